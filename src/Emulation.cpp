@@ -10,7 +10,9 @@
 #include "Emulation.h"
 
 // Qt
+#include <QGuiApplication>
 #include <QKeyEvent>
+#include <QScreen>
 
 // Konsole
 #include "KonsoleSettings.h"
@@ -28,8 +30,11 @@ Emulation::Emulation()
     _screen[1] = new Screen(40, 80);
     _currentScreen = _screen[0];
 
-    QObject::connect(&_bulkTimer1, &QTimer::timeout, this, &Konsole::Emulation::showBulk);
-    QObject::connect(&_bulkTimer2, &QTimer::timeout, this, &Konsole::Emulation::showBulk);
+    _frameTimer.setSingleShot(true);
+    _synchronizedUpdateTimer.setSingleShot(true);
+    QObject::connect(&_frameTimer, &QTimer::timeout, this, &Konsole::Emulation::showBulk);
+    QObject::connect(&_synchronizedUpdateTimer, &QTimer::timeout, this, &Konsole::Emulation::showBulk);
+    _frameInterval = refreshInterval();
 
     // listen for mouse status changes
     connect(this, &Konsole::Emulation::programRequestsMouseTracking, this, &Konsole::Emulation::setUsesMouseTracking);
@@ -67,16 +72,15 @@ void Emulation::synchronizedUpdateChanged(bool inProgress)
     if (!old && inProgress) {
         static const int SYNCHRONIZED_TIMEOUT = 1000;
 
-        _bulkTimer1.stop();
-
-        _bulkTimer2.setSingleShot(true);
-        _bulkTimer2.start(SYNCHRONIZED_TIMEOUT);
+        _frameTimer.stop();
+        _synchronizedUpdateTimer.start(SYNCHRONIZED_TIMEOUT);
     }
 }
 
 ScreenWindow *Emulation::createWindow()
 {
     auto window = new ScreenWindow(_currentScreen);
+    window->setRenderStatistics(&_renderStatistics);
     _windows << window;
 
     connect(window, &Konsole::ScreenWindow::selectionChanged, this, &Konsole::Emulation::bufferedUpdate);
@@ -176,6 +180,12 @@ bool Emulation::setCodec(const QByteArray &name)
         if (decoder.isValid() && encoder.isValid()) {
             _decoder = std::move(decoder);
             _encoder = std::move(encoder);
+            _utf8Input = utf8();
+            _utf8Codepoint = 0;
+            _utf8BytesNeeded = 0;
+            _utf8LowerBoundary = 0x80;
+            _utf8UpperBoundary = 0xBF;
+            _utf8AtStart = true;
             Q_EMIT useUtf8Request(utf8());
             return true;
         }
@@ -260,10 +270,22 @@ void Emulation::receiveData(const char *text, int length)
 
     bufferedUpdate();
 
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+
     // send characters to terminal emulator
-    const QString readString = _decoder.decode(QByteArrayView(text, length));
-    const QVector<uint> chars = readString.toUcs4();
-    receiveChars(chars);
+    if (_utf8Input) {
+        decodeUtf8(text, length);
+        receiveChars(_receiveBuffer);
+    } else {
+        const QString readString = _decoder.decode(QByteArrayView(text, length));
+        const QVector<uint> chars = readString.toUcs4();
+        receiveChars(chars);
+    }
+
+    const qint64 parseTime = parseTimer.nsecsElapsed();
+    _parseTime += parseTime;
+    _renderStatistics.addTime(RenderStatistics::Parse, parseTime);
 
     if (KonsoleSettings::listenForZModemTerminalCodes() == false) {
         return;
@@ -290,6 +312,88 @@ void Emulation::receiveData(const char *text, int length)
     }
 }
 
+void Emulation::decodeUtf8(const char *text, int length)
+{
+    // Every byte produces at most one character, plus one replacement
+    // character for a sequence left incomplete by the previous call
+    _receiveBuffer.resize(length + 1);
+    uint *out = _receiveBuffer.data();
+    const uint *const outStart = out;
+
+    const auto *bytes = reinterpret_cast<const uchar *>(text);
+    const uchar *const end = bytes + length;
+
+    // This follows the decoder of the WHATWG Encoding Standard, which replaces
+    // each maximal subpart of a malformed sequence with one U+FFFD
+    while (bytes < end) {
+        if (_utf8BytesNeeded == 0) {
+            // ASCII needs no state, so consume it in a tight loop
+            while (bytes < end && *bytes < 0x80) {
+                *out++ = *bytes++;
+            }
+            if (bytes == end) {
+                break;
+            }
+
+            const uchar b = *bytes++;
+            if (b >= 0xC2 && b <= 0xDF) {
+                _utf8BytesNeeded = 1;
+                _utf8Codepoint = b & 0x1F;
+            } else if (b >= 0xE0 && b <= 0xEF) {
+                if (b == 0xE0) {
+                    _utf8LowerBoundary = 0xA0; // overlong
+                } else if (b == 0xED) {
+                    _utf8UpperBoundary = 0x9F; // surrogates
+                }
+                _utf8BytesNeeded = 2;
+                _utf8Codepoint = b & 0x0F;
+            } else if (b >= 0xF0 && b <= 0xF4) {
+                if (b == 0xF0) {
+                    _utf8LowerBoundary = 0x90; // overlong
+                } else if (b == 0xF4) {
+                    _utf8UpperBoundary = 0x8F; // beyond U+10FFFF
+                }
+                _utf8BytesNeeded = 3;
+                _utf8Codepoint = b & 0x07;
+            } else {
+                *out++ = QChar::ReplacementCharacter;
+            }
+            continue;
+        }
+
+        const uchar b = *bytes;
+        if (b < _utf8LowerBoundary || b > _utf8UpperBoundary) {
+            // Malformed sequence, b is processed again as the start of a new one
+            _utf8Codepoint = 0;
+            _utf8BytesNeeded = 0;
+            _utf8LowerBoundary = 0x80;
+            _utf8UpperBoundary = 0xBF;
+            *out++ = QChar::ReplacementCharacter;
+            continue;
+        }
+
+        ++bytes;
+        _utf8LowerBoundary = 0x80;
+        _utf8UpperBoundary = 0xBF;
+        _utf8Codepoint = (_utf8Codepoint << 6) | (b & 0x3F);
+        if (--_utf8BytesNeeded == 0) {
+            *out++ = _utf8Codepoint;
+            _utf8Codepoint = 0;
+        }
+    }
+
+    _receiveBuffer.resize(out - outStart);
+
+    // Like QStringDecoder, drop a byte order mark at the start of the stream,
+    // which may be split across reads
+    if (_utf8AtStart && !_receiveBuffer.isEmpty()) {
+        _utf8AtStart = false;
+        if (_receiveBuffer.first() == 0xFEFF) {
+            _receiveBuffer.removeFirst();
+        }
+    }
+}
+
 void Emulation::writeToStream(TerminalCharacterDecoder *decoder, int startLine, int endLine)
 {
     _currentScreen->writeLinesToStream(decoder, startLine, endLine);
@@ -301,34 +405,99 @@ int Emulation::lineCount() const
     return _currentScreen->getLines() + _currentScreen->getHistLines();
 }
 
+// Delay before showing output which arrives after the output was idle for
+// a frame, so that the rest of a burst of output is shown with it, in ms
+static const int SETTLE_DELAY = 10;
+// Longest interval between frames while output arrives continuously, in ms
+static const int MAX_FRAME_INTERVAL = 100;
+
 void Emulation::showBulk()
 {
     _synchronizedUpdate = false;
 
-    _bulkTimer1.stop();
-    _bulkTimer2.stop();
+    _frameTimer.stop();
+    _synchronizedUpdateTimer.stop();
+
+    // The refreshes of the screen while the update was delayed, by frame
+    // pacing or by a synchronized update, didn't show it
+    const int skippedFrames = _updatePending.isValid() ? int(_updatePending.elapsed() / refreshInterval()) : 0;
+    _updatePending.invalidate();
+
+    // Output which scrolled by more than a screen since the last frame is
+    // scrolling faster than it can be read
+    const bool flood = qAbs(_currentScreen->scrolledLines()) >= _currentScreen->getLines();
+
+    QElapsedTimer frameTimer;
+    frameTimer.start();
 
     Q_EMIT updateDroppedLines(_currentScreen->fastDroppedLines() + _currentScreen->droppedLines());
     Q_EMIT outputChanged();
 
+    adaptFrameInterval(frameTimer.nsecsElapsed(), flood);
+
+    _renderStatistics.addFrame(skippedFrames);
+    _renderStatistics.report();
+
     _currentScreen->resetScrolledLines();
     _currentScreen->resetDroppedLines();
 }
 
+void Emulation::adaptFrameInterval(qint64 frameTime, bool flood)
+{
+    // Output is arriving faster than it is parsed if parsing took most of the
+    // time since the last frame
+    const bool busy = _lastFrame.isValid() && _parseTime > _lastFrame.nsecsElapsed() / 2;
+
+    int interval = refreshInterval();
+    if (busy || flood) {
+        // Spend at most a quarter of the time updating the views, to parse
+        // the output sooner, and skip the frames of output which scrolls
+        // faster than it can be read
+        interval = qMax(interval, int(frameTime * 4 / 1000000));
+        if (flood) {
+            interval = qMax(interval, _frameInterval * 2);
+        }
+    }
+    _frameInterval = qMin(interval, MAX_FRAME_INTERVAL);
+
+    _parseTime = 0;
+    _lastFrame.start();
+}
+
+int Emulation::refreshInterval() const
+{
+    qreal refreshRate = 0;
+    for (const ScreenWindow *window : std::as_const(_windows)) {
+        refreshRate = qMax(refreshRate, window->refreshRate());
+    }
+    if (refreshRate < 1) {
+        const QScreen *screen = QGuiApplication::primaryScreen();
+        refreshRate = screen != nullptr ? screen->refreshRate() : 0;
+    }
+    return refreshRate >= 1 ? qMax(1, qRound(1000 / refreshRate)) : 16;
+}
+
 void Emulation::bufferedUpdate()
 {
+    if (!_updatePending.isValid()) {
+        _updatePending.start();
+    }
+
     if (_synchronizedUpdate)
         return;
 
-    static const int BULK_TIMEOUT1 = 10;
-    static const int BULK_TIMEOUT2 = 40;
+    if (_frameTimer.isActive()) {
+        return;
+    }
 
-    _bulkTimer1.setSingleShot(true);
-    _bulkTimer1.start(BULK_TIMEOUT1);
-    if (!_bulkTimer2.isActive()) {
-        _bulkTimer2.setSingleShot(true);
-        _bulkTimer2.start(BULK_TIMEOUT2);
+    // Show the output at the next frame, but let output arriving after an
+    // idle period settle first
+    const int settleDelay = qMin(SETTLE_DELAY, _frameInterval);
+    int delay = settleDelay;
+    if (_lastFrame.isValid()) {
+        delay = qBound(settleDelay, int(_frameInterval - _lastFrame.elapsed()), _frameInterval);
     }
+    _frameTimer.start(delay);
 }
 
 char Emulation::eraseChar() const
@@ -374,6 +543,11 @@ QSize Emulation::imageSize() const
     return {_currentScreen->getColumns(), _currentScreen->getLines()};
 }
 
+RenderStatistics *Emulation::renderStatistics()
+{
+    return &_renderStatistics;
+}
+
 QList<int> Emulation::getCurrentScreenCharacterCounts() const
 {
     return _currentScreen->getCharacterCounts();
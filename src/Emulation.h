@@ -9,6 +9,7 @@
 #define EMULATION_H
 
 // Qt
+#include <QElapsedTimer>
 #include <QSize>
 #include <QStringDecoder>
 #include <QStringEncoder>
@@ -16,6 +17,7 @@
 
 // Konsole
 #include "Enumeration.h"
+#include "RenderStatistics.h"
 #include "konsoleprivate_export.h"
 #include "terminalDisplay/TerminalDisplay.h"
 
@@ -104,6 +106,12 @@ public:
     /** Returns the size of the screen image which the emulation produces */
     QSize imageSize() const;
 
+    /**
+     * Returns the statistics of the time spent showing the output of this
+     * emulation, which are shared by the windows onto it.
+     */
+    RenderStatistics *renderStatistics();
+
     /**
      * Returns the total number of lines, including those stored in the history.
      */
@@ -490,6 +498,13 @@ protected:
 
     void setCodec(EmulationCodec codec);
 
+    /**
+     * Decodes @p length bytes of UTF-8 from @p text into _receiveBuffer.
+     * Incomplete sequences at the end of @p text are kept and completed by the
+     * next call, malformed sequences are replaced with U+FFFD.
+     */
+    void decodeUtf8(const char *text, int length);
+
     QList<ScreenWindow *> _windows;
 
     Screen *_currentScreen = nullptr; // pointer to the screen which is currently active,
@@ -507,6 +522,19 @@ protected:
     // (this allows for rendering of non-ASCII characters in text files etc.)
     QStringEncoder _encoder;
 
+    // UTF-8 input is decoded by decodeUtf8() rather than _decoder
+    bool _utf8Input = false;
+
+    // state of decodeUtf8() between calls to receiveData()
+    uint _utf8Codepoint = 0;
+    int _utf8BytesNeeded = 0;
+    uchar _utf8LowerBoundary = 0x80;
+    uchar _utf8UpperBoundary = 0xBF;
+    bool _utf8AtStart = true;
+
+    // decoded characters of the current receiveData() call, reused between calls
+    QVector<uint> _receiveBuffer;
+
     const KeyboardTranslator *_keyTranslator = nullptr; // the keyboard layout
 
 protected Q_SLOTS:
@@ -536,13 +564,30 @@ private Q_SLOTS:
 
 private:
     void setScreenInternal(int index);
+
+    // adapts the interval between frames to the cost of the last one, which
+    // took 'frameTime' ns, and to the rate of output
+    void adaptFrameInterval(qint64 frameTime, bool flood);
+    // interval between refreshes of the fastest screen the views are shown
+    // on, or of the primary screen if they aren't shown, in ms
+    int refreshInterval() const;
+
     Q_DISABLE_COPY(Emulation)
 
     bool _usesMouseTracking = false;
     bool _bracketedPasteMode = false;
     bool _synchronizedUpdate = false;
-    QTimer _bulkTimer1{this};
-    QTimer _bulkTimer2{this};
+    QTimer _frameTimer{this}; // shows the output at the next frame, see bufferedUpdate()
+    QTimer _synchronizedUpdateTimer{this}; // ends synchronized updates which take too long
+
+    // frame pacing, see adaptFrameInterval()
+    QElapsedTimer _lastFrame;
+    qint64 _parseTime = 0; // time spent parsing output since the last frame, in ns
+    int _frameInterval = 16; // in ms
+    QElapsedTimer _updatePending; // started when output or the selection changed since the last frame
+
+    RenderStatistics _renderStatistics;
+
     bool _imageSizeInitialized = false;
     bool _peekingPrimary = false;
     int _activeScreenIndex = 0;
@@ -0,0 +1,150 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Own
+#include "ProcFile.h"
+
+// Unix
+#ifndef Q_OS_WIN
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace Konsole;
+
+static bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n';
+}
+
+// Returns the first field of 'data', which are separated by blanks, and
+// removes it from 'data'
+static QByteArrayView takeField(QByteArrayView &data)
+{
+    qsizetype start = 0;
+    while (start < data.size() && isBlank(data[start])) {
+        start++;
+    }
+    qsizetype end = start;
+    while (end < data.size() && !isBlank(data[end])) {
+        end++;
+    }
+
+    const QByteArrayView field = data.sliced(start, end - start);
+    data = data.sliced(end);
+    return field;
+}
+
+ProcFile::~ProcFile()
+{
+#ifndef Q_OS_WIN
+    if (_fd != -1) {
+        ::close(_fd);
+    }
+#endif
+}
+
+bool ProcFile::open(int pid, const char *name)
+{
+#ifndef Q_OS_WIN
+    if (_fd != -1) {
+        ::close(_fd);
+    }
+
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/%s", pid, name);
+    _fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    return _fd != -1;
+#else
+    Q_UNUSED(pid);
+    Q_UNUSED(name);
+    return false;
+#endif
+}
+
+bool ProcFile::isOpen() const
+{
+    return _fd != -1;
+}
+
+QByteArrayView ProcFile::read()
+{
+#ifndef Q_OS_WIN
+    if (_fd == -1) {
+        return {};
+    }
+
+    // The files of /proc are generated anew when read from their start
+    qsizetype length = 0;
+    while (length < BUFFER_SIZE) {
+        const ssize_t result = ::pread(_fd, _buffer + length, BUFFER_SIZE - length, length);
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            if (result == -1) {
+                return {};
+            }
+            break;
+        }
+        length += result;
+    }
+    return QByteArrayView(_buffer, length);
+#else
+    return {};
+#endif
+}
+
+std::optional<ProcFile::Stat> ProcFile::parseStat(QByteArrayView data)
+{
+    // The format is a list of fields separated by spaces:
+    //
+    // PID (NAME) STATE PPID PGRP SESSION TTY TPGID ...
+    //
+    // The name may contain spaces and parentheses, the fields after it don't
+    const qsizetype nameStart = data.indexOf('(');
+    const qsizetype nameEnd = data.lastIndexOf(')');
+    if (nameStart == -1 || nameEnd < nameStart) {
+        return std::nullopt;
+    }
+
+    Stat stat;
+    stat.name = data.sliced(nameStart + 1, nameEnd - nameStart - 1);
+
+    QByteArrayView fields = data.sliced(nameEnd + 1);
+    takeField(fields); // state
+    bool parentPidOk = false;
+    stat.parentPid = takeField(fields).toInt(&parentPidOk);
+    takeField(fields); // process group
+    takeField(fields); // session
+    takeField(fields); // terminal
+    bool foregroundPidOk = false;
+    stat.foregroundPid = takeField(fields).toInt(&foregroundPidOk);
+    if (!parentPidOk || !foregroundPidOk) {
+        return std::nullopt;
+    }
+    return stat;
+}
+
+std::optional<int> ProcFile::parseStatusUid(QByteArrayView data)
+{
+    // The line is 'Uid: REAL EFFECTIVE SAVED FILESYSTEM'
+    while (!data.isEmpty()) {
+        const qsizetype lineEnd = data.indexOf('\n');
+        QByteArrayView line = lineEnd == -1 ? data : data.first(lineEnd);
+        data = lineEnd == -1 ? QByteArrayView() : data.sliced(lineEnd + 1);
+
+        if (line.startsWith("Uid:")) {
+            line = line.sliced(4);
+            bool ok = false;
+            const int uid = takeField(line).toInt(&ok);
+            return ok ? std::optional<int>(uid) : std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
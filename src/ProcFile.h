@@ -0,0 +1,72 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef PROCFILE_H
+#define PROCFILE_H
+
+// Qt
+#include <QByteArrayView>
+
+// Konsole
+#include "konsoleprivate_export.h"
+
+#include <optional>
+
+namespace Konsole
+{
+/**
+ * A file of /proc/<pid>, which is kept open and read again from its start
+ * with pread() into a fixed buffer, so that reading the state of a process
+ * again neither opens files nor allocates memory.
+ *
+ * The parsers work on the raw contents of the files without allocating
+ * either.
+ */
+class KONSOLEPRIVATE_EXPORT ProcFile
+{
+public:
+    /** Files longer than this are truncated by read() */
+    static constexpr int BUFFER_SIZE = 4096;
+
+    ProcFile() = default;
+    ~ProcFile();
+
+    /**
+     * Opens the file @p name of the process @p pid.
+     * Returns false and leaves errno set if it can't be opened.
+     */
+    bool open(int pid, const char *name);
+    /** Returns true if open() succeeded */
+    bool isOpen() const;
+
+    /**
+     * Reads the file from its start. Returns the contents, which are valid
+     * until the next call, or an empty view if they can't be read, e.g.
+     * because the process exited.
+     */
+    QByteArrayView read();
+
+    /** The fields of /proc/<pid>/stat which Konsole uses */
+    struct Stat {
+        QByteArrayView name;
+        int parentPid = 0;
+        int foregroundPid = 0; // the foreground process group of the terminal
+    };
+    /** Parses the contents of /proc/<pid>/stat */
+    static std::optional<Stat> parseStat(QByteArrayView data);
+    /** Returns the real user id on the Uid: line of the contents of /proc/<pid>/status */
+    static std::optional<int> parseStatusUid(QByteArrayView data);
+
+private:
+    Q_DISABLE_COPY(ProcFile)
+
+    int _fd = -1;
+    char _buffer[BUFFER_SIZE];
+};
+
+}
+
+#endif // PROCFILE_H
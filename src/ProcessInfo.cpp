@@ -17,6 +17,7 @@
 #ifndef Q_OS_WIN
 #include <arpa/inet.h>
 #include <cerrno>
+#include <cstdio>
 #include <netinet/in.h>
 #include <pwd.h>
 #include <sys/param.h>
@@ -348,6 +349,7 @@ void ProcessInfo::setFileError(QFile::FileError error)
 #include <QVariant>
 
 #include "KonsoleSettings.h"
+#include "ProcFile.h"
 
 typedef QPair<QString, QDBusVariant> VariantPair;
 typedef QList<VariantPair> VariantList;
@@ -446,19 +448,21 @@ public:
 protected:
     bool readCurrentDir(int pid) override
     {
+        char procCwd[64];
+        snprintf(procCwd, sizeof(procCwd), "/proc/%d/cwd", pid);
         char path_buffer[MAXPATHLEN + 1];
-        path_buffer[MAXPATHLEN] = 0;
-        QByteArray procCwd = QFile::encodeName(QStringLiteral("/proc/%1/cwd").arg(pid));
-        const auto length = static_cast<int>(readlink(procCwd.constData(), path_buffer, MAXPATHLEN));
+        const auto length = static_cast<int>(readlink(procCwd, path_buffer, MAXPATHLEN));
         if (length == -1) {
             setError(UnknownError);
             return false;
         }
 
-        path_buffer[length] = '\0';
-        QString path = QFile::decodeName(path_buffer);
-
-        setCurrentDir(path);
+        // only decode the path when it changed
+        const QByteArrayView path(path_buffer, length);
+        if (path != _currentDir) {
+            _currentDir = path.toByteArray();
+            setCurrentDir(QFile::decodeName(_currentDir));
+        }
         return true;
     }
 
@@ -466,146 +470,72 @@ protected:
     {
         Q_UNUSED(pid);
 
-        if (!_infoFile || _infoFile->error() != 0 || !_infoFile->reset()) {
+        if (!_statFile.isOpen()) {
             return false;
         }
 
-        const QString data = QString::fromUtf8(_infoFile->readLine());
-
-        if (data.isEmpty()) {
-            setName(data);
+        const std::optional<ProcFile::Stat> stat = ProcFile::parseStat(_statFile.read());
+        if (!stat) {
+            _name.clear();
+            setName(QString());
             return false;
         }
 
-        const int nameStartIdx = data.indexOf(QLatin1Char('(')) + 1;
-        const int nameLength = data.lastIndexOf(QLatin1Char(')')) - nameStartIdx;
-
-        setName(data.mid(nameStartIdx, nameLength));
+        // only decode the name when it changed
+        if (stat->name != _name) {
+            _name = stat->name.toByteArray();
+            setName(QString::fromUtf8(_name));
+        }
         return true;
     }
 
 private:
-    bool readProcInfo(int pid) override
+    void setProcFileError()
     {
-        // indices of various fields within the process status file which
-        // contain various information about the process
-        const int PARENT_PID_FIELD = 3;
-        const int PROCESS_NAME_FIELD = 1;
-        const int GROUP_PROCESS_FIELD = 7;
-
-        QString parentPidString;
-        QString processNameString;
-        QString foregroundPidString;
-        QString uidLine;
-        QString uidString;
-        QStringList uidStrings;
+        setError(errno == EACCES || errno == EPERM ? PermissionsError : UnknownError);
+    }
 
+    bool readProcInfo(int pid) override
+    {
         // For user id read process status file ( /proc/<pid>/status )
         //  Can not use getuid() due to it does not work for 'su'
-        QFile statusInfo(QStringLiteral("/proc/%1/status").arg(pid));
-        if (statusInfo.open(QIODevice::ReadOnly)) {
-            QTextStream stream(&statusInfo);
-            QString statusLine;
-            do {
-                statusLine = stream.readLine();
-                if (statusLine.startsWith(QLatin1String("Uid:"))) {
-                    uidLine = statusLine;
-                }
-            } while (!statusLine.isNull() && uidLine.isNull());
-
-            uidStrings << uidLine.split(QLatin1Char('\t'), Qt::SkipEmptyParts);
-            // Must be 5 entries: 'Uid: %d %d %d %d' and
-            // uid string must be less than 5 chars (uint)
-            if (uidStrings.size() == 5) {
-                uidString = uidStrings[1];
-            }
-            if (uidString.size() > 5) {
-                uidString.clear();
-            }
-
-            bool ok = false;
-            const int uid = uidString.toInt(&ok);
-            if (ok) {
-                setUserId(uid);
-            }
-            // This will cause constant opening of /etc/passwd
-            if (userNameRequired()) {
-                readUserName();
-                setUserNameRequired(false);
-            }
-        } else {
-            setFileError(statusInfo.error());
+        ProcFile statusFile;
+        if (!statusFile.open(pid, "status")) {
+            setProcFileError();
             return false;
         }
-
-        // read process status file ( /proc/<pid/stat )
-        //
-        // the expected file format is a list of fields separated by spaces, using
-        // parentheses to escape fields such as the process name which may itself contain
-        // spaces:
-        //
-        // FIELD FIELD (FIELD WITH SPACES) FIELD FIELD
-        //
-        _infoFile = std::make_unique<QFile>();
-        _infoFile->setFileName(QStringLiteral("/proc/%1/stat").arg(pid));
-        if (_infoFile->open(QIODevice::ReadOnly)) {
-            QTextStream stream(_infoFile.get());
-            const QString &data = stream.readAll();
-
-            int field = 0;
-            int pos = 0;
-
-            while (pos < data.length()) {
-                QChar c = data[pos];
-
-                if (c == QLatin1Char(' ')) {
-                    field++;
-                } else {
-                    switch (field) {
-                    case PARENT_PID_FIELD:
-                        parentPidString.append(c);
-                        break;
-                    case PROCESS_NAME_FIELD: {
-                        pos++;
-                        const int NAME_MAX_LEN = 16;
-                        const int nameEndIdx = data.lastIndexOf(QStringLiteral(")"), pos + NAME_MAX_LEN);
-                        processNameString = data.mid(pos, nameEndIdx - pos);
-                        pos = nameEndIdx;
-                        break;
-                    }
-                    case GROUP_PROCESS_FIELD:
-                        foregroundPidString.append(c);
-                        break;
-                    }
-                }
-
-                pos++;
-            }
-        } else {
-            setFileError(_infoFile->error());
-            return false;
+        const std::optional<int> uid = ProcFile::parseStatusUid(statusFile.read());
+        if (uid) {
+            setUserId(*uid);
         }
-
-        // check that data was read successfully
-        bool ok = false;
-        const int foregroundPid = foregroundPidString.toInt(&ok);
-        if (ok) {
-            setForegroundPid(foregroundPid);
+        // This will cause constant opening of /etc/passwd
+        if (userNameRequired()) {
+            readUserName();
+            setUserNameRequired(false);
         }
 
-        const int parentPid = parentPidString.toInt(&ok);
-        if (ok) {
-            setParentPid(parentPid);
+        // read process status file ( /proc/<pid/stat ), which is kept open
+        // for reading the name again in readProcessName()
+        if (!_statFile.open(pid, "stat")) {
+            setProcFileError();
+            return false;
+        }
+        const std::optional<ProcFile::Stat> stat = ProcFile::parseStat(_statFile.read());
+        if (!stat) {
+            setError(UnknownError);
+            return false;
         }
 
-        if (!processNameString.isEmpty()) {
-            setName(processNameString);
+        setForegroundPid(stat->foregroundPid);
+        setParentPid(stat->parentPid);
+        if (!stat->name.isEmpty()) {
+            setName(QString::fromUtf8(stat->name));
         }
 
         // update object state
         setPid(pid);
 
-        return ok;
+        return true;
     }
 
     QDBusMessage callSmdDBus(const QString &objectPath,
@@ -782,7 +712,11 @@ private:
 
     static QString _createdAppCGroupPath;
     static bool _cGroupCreationFailed;
-    std::unique_ptr<QFile> _infoFile;
+    ProcFile _statFile;
+    // the raw name and current directory last read, see readProcessName()
+    // and readCurrentDir()
+    QByteArray _name;
+    QByteArray _currentDir;
 };
 
 QString LinuxProcessInfo::_createdAppCGroupPath = QString();
@@ -25,6 +25,9 @@
 #include <KPtyDevice>
 #include <KSandbox>
 
+// Konsole
+#include "PtyReader.h"
+
 using Konsole::Pty;
 
 static int getShellProcessId(QLatin1String tty)
@@ -115,12 +118,31 @@ void Pty::sendData(const QByteArray &data)
 
 void Pty::dataReceived()
 {
-    QByteArray data = pty()->readAll();
-    if (data.isEmpty()) {
+    // Read in chunks instead of allocating the whole buffered output with readAll()
+    char buffer[16 * 1024];
+    qint64 length;
+    while ((length = pty()->read(buffer, sizeof(buffer))) > 0) {
+        Q_EMIT receivedData(buffer, length);
+    }
+}
+
+void Pty::startReaderThread()
+{
+    if (_reader || pty()->masterFd() < 0) {
         return;
     }
 
-    Q_EMIT receivedData(data.constData(), data.length());
+    // Stop KPtyDevice from reading, but pass on what it has buffered already
+    pty()->setSuspended(true);
+    dataReceived();
+
+    _reader = std::make_unique<PtyReader>(pty()->masterFd());
+    if (!_reader->isValid()) {
+        _reader.reset();
+        pty()->setSuspended(false);
+        return;
+    }
+    connect(_reader.get(), &PtyReader::receivedData, this, &Pty::receivedData);
 }
 
 void Pty::setWindowSize(int columns, int lines, int width, int height)
@@ -326,6 +348,8 @@ void Pty::setWriteable(bool writeable)
 
 void Pty::closePty()
 {
+    // the reader thread must not read from the closed file descriptor
+    _reader.reset();
     pty()->close();
 }
 
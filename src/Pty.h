@@ -24,8 +24,13 @@
 #include "ptyqt/iptyprocess.h"
 #endif
 
+// STD
+#include <memory>
+
 namespace Konsole
 {
+class PtyReader;
+
 /**
  * The Pty class is used to start the terminal process,
  * send data to it, receive data from it and manipulate
@@ -154,6 +159,15 @@ public:
      */
     void closePty();
 
+#ifndef Q_OS_WIN
+    /**
+     * Reads the output of the terminal in a thread of its own from now on,
+     * so that a slow repaint does not stop the terminal program from
+     * writing. See PtyReader.
+     */
+    void startReaderThread();
+#endif
+
     /**
      * Returns the shell process id
      */
@@ -243,6 +257,8 @@ private:
 #else
     // Use shellProcessId() instead
     using ParentClass::processId;
+
+    std::unique_ptr<PtyReader> _reader;
 #endif
 };
 }
@@ -0,0 +1,198 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Own
+#include "PtyReader.h"
+
+#include "konsoledebug.h"
+
+// Qt
+#include <QThread>
+
+// System
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace Konsole;
+
+// Enough for a few frames of output of a fast program, e.g. a build
+static const qsizetype BUFFER_SIZE = 1024 * 1024;
+// The most output parsed before the event loop may paint again
+static const qsizetype MAX_SLICE_SIZE = 64 * 1024;
+
+PtyRingBuffer::PtyRingBuffer(qsizetype capacity)
+    : _capacity(capacity)
+    , _data(new char[capacity])
+{
+    Q_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+}
+
+qsizetype PtyRingBuffer::size() const
+{
+    const quint64 readPosition = _readPosition.load(std::memory_order_acquire);
+    return _writePosition.load(std::memory_order_acquire) - readPosition;
+}
+
+std::span<char> PtyRingBuffer::writeSpan()
+{
+    const quint64 writePosition = _writePosition.load(std::memory_order_relaxed);
+    const qsizetype used = writePosition - _readPosition.load(std::memory_order_acquire);
+    const qsizetype offset = writePosition & (_capacity - 1);
+    return {_data.get() + offset, size_t(qMin(_capacity - used, _capacity - offset))};
+}
+
+void PtyRingBuffer::commitWrite(qsizetype length)
+{
+    Q_ASSERT(length >= 0 && length <= qsizetype(writeSpan().size()));
+    _writePosition.store(_writePosition.load(std::memory_order_relaxed) + length, std::memory_order_release);
+}
+
+QByteArrayView PtyRingBuffer::readView() const
+{
+    const quint64 readPosition = _readPosition.load(std::memory_order_relaxed);
+    const qsizetype used = _writePosition.load(std::memory_order_acquire) - readPosition;
+    const qsizetype offset = readPosition & (_capacity - 1);
+    return QByteArrayView(_data.get() + offset, qMin(used, _capacity - offset));
+}
+
+void PtyRingBuffer::commitRead(qsizetype length)
+{
+    Q_ASSERT(length >= 0 && length <= readView().size());
+    _readPosition.store(_readPosition.load(std::memory_order_relaxed) + length, std::memory_order_release);
+}
+
+PtyReader::PtyReader(int fd, QObject *parent)
+    : QObject(parent)
+    , _fd(fd)
+    , _buffer(BUFFER_SIZE)
+{
+    if (pipe(_wakeUpPipe) < 0) {
+        qCWarning(KonsoleDebug) << "Unable to create a pipe for the terminal reader thread:" << strerror(errno);
+        _wakeUpPipe[0] = _wakeUpPipe[1] = -1;
+        return;
+    }
+    for (int pipeFd : _wakeUpPipe) {
+        fcntl(pipeFd, F_SETFD, FD_CLOEXEC);
+        fcntl(pipeFd, F_SETFL, fcntl(pipeFd, F_GETFL) | O_NONBLOCK);
+    }
+
+    _thread = QThread::create([this]() {
+        readLoop();
+    });
+    _thread->setObjectName(QStringLiteral("PtyReader"));
+    _thread->start();
+}
+
+PtyReader::~PtyReader()
+{
+    if (_thread != nullptr) {
+        _stopRequested.store(true);
+        wakeUp();
+        _thread->wait();
+        delete _thread;
+    }
+    for (int pipeFd : _wakeUpPipe) {
+        if (pipeFd >= 0) {
+            close(pipeFd);
+        }
+    }
+}
+
+qsizetype PtyReader::maxSliceSize()
+{
+    return MAX_SLICE_SIZE;
+}
+
+void PtyReader::readLoop()
+{
+    pollfd fds[2] = {{_fd, POLLIN, 0}, {_wakeUpPipe[0], POLLIN, 0}};
+
+    while (!_stopRequested.load()) {
+        std::span<char> space = _buffer.writeSpan();
+        if (space.empty()) {
+            _waitingForSpace.store(true);
+            // emitSlice() may have made space before it could see the flag
+            space = _buffer.writeSpan();
+            if (!space.empty()) {
+                _waitingForSpace.store(false);
+            }
+        }
+
+        // A negative fd is ignored by poll(), only wait for a wake up while the buffer is full
+        fds[0].fd = space.empty() ? -1 : _fd;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            qCWarning(KonsoleDebug) << "Unable to wait for terminal output:" << strerror(errno);
+            break;
+        }
+
+        if (fds[1].revents != 0) {
+            char wakeUps[64];
+            while (read(_wakeUpPipe[0], wakeUps, sizeof(wakeUps)) > 0) { }
+        }
+
+        if (fds[0].fd >= 0 && fds[0].revents != 0) {
+            const ssize_t length = read(_fd, space.data(), space.size());
+            if (length > 0) {
+                _buffer.commitWrite(length);
+                scheduleSlice();
+            } else if (length == 0 || (errno != EINTR && errno != EAGAIN)) {
+                // the end of the output, Linux reports EIO once the terminal program closed the pty
+                break;
+            }
+        }
+    }
+}
+
+void PtyReader::scheduleSlice()
+{
+    if (!_slicePending.exchange(true)) {
+        QMetaObject::invokeMethod(this, &PtyReader::emitSlice, Qt::QueuedConnection);
+    }
+}
+
+void PtyReader::emitSlice()
+{
+    // Cleared before reading, so output written from now on schedules another slice
+    _slicePending.store(false);
+
+    qsizetype remaining = MAX_SLICE_SIZE;
+    while (remaining > 0) {
+        QByteArrayView data = _buffer.readView();
+        if (data.isEmpty()) {
+            break;
+        }
+        data = data.first(qMin(data.size(), remaining));
+
+        Q_EMIT receivedData(data.data(), data.size());
+
+        _buffer.commitRead(data.size());
+        remaining -= data.size();
+        if (_waitingForSpace.exchange(false)) {
+            wakeUp();
+        }
+    }
+
+    // Let the event loop paint before parsing the rest
+    if (_buffer.size() > 0) {
+        scheduleSlice();
+    }
+}
+
+void PtyReader::wakeUp()
+{
+    const char byte = 0;
+    if (write(_wakeUpPipe[1], &byte, 1) < 0 && errno != EAGAIN) {
+        qCWarning(KonsoleDebug) << "Unable to wake up the terminal reader thread:" << strerror(errno);
+    }
+}
+
+#include "moc_PtyReader.cpp"
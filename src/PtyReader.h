@@ -0,0 +1,117 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef PTYREADER_H
+#define PTYREADER_H
+
+// Qt
+#include <QByteArrayView>
+#include <QObject>
+
+// Konsole
+#include "konsoleprivate_export.h"
+
+// STD
+#include <atomic>
+#include <memory>
+#include <span>
+
+class QThread;
+
+namespace Konsole
+{
+/**
+ * A byte queue of fixed capacity between one producer and one consumer
+ * thread, which never allocates after construction.
+ *
+ * The producer writes into writeSpan() and publishes the bytes with
+ * commitWrite(), the consumer reads readView() and releases the bytes with
+ * commitRead(). Both spans are contiguous, so they may be shorter than the
+ * free or used space when it wraps around the end of the buffer.
+ */
+class KONSOLEPRIVATE_EXPORT PtyRingBuffer
+{
+public:
+    /** @p capacity must be a power of two */
+    explicit PtyRingBuffer(qsizetype capacity);
+
+    qsizetype capacity() const
+    {
+        return _capacity;
+    }
+
+    /** Returns the number of bytes which can be read */
+    qsizetype size() const;
+
+    /** Producer: returns the free space at the write position */
+    std::span<char> writeSpan();
+    /** Producer: publishes @p length bytes written to writeSpan() */
+    void commitWrite(qsizetype length);
+
+    /** Consumer: returns the bytes at the read position */
+    QByteArrayView readView() const;
+    /** Consumer: releases @p length bytes of readView() */
+    void commitRead(qsizetype length);
+
+private:
+    Q_DISABLE_COPY(PtyRingBuffer)
+
+    const qsizetype _capacity;
+    std::unique_ptr<char[]> _data;
+    // Positions since the start, only written by the producer and the consumer
+    std::atomic<quint64> _writePosition = 0;
+    std::atomic<quint64> _readPosition = 0;
+};
+
+/**
+ * Reads the output of a terminal in a thread of its own, so that a slow
+ * repaint in the GUI thread does not stop the terminal program from writing.
+ *
+ * The output is buffered in a PtyRingBuffer and emitted with receivedData()
+ * in the thread of the reader object, in slices of at most maxSliceSize()
+ * bytes per turn of the event loop. The reader thread only stops reading from
+ * the terminal while the buffer is full, or after the end of the output.
+ */
+class KONSOLEPRIVATE_EXPORT PtyReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** Starts reading from @p fd, which must stay open while the reader exists */
+    explicit PtyReader(int fd, QObject *parent = nullptr);
+    ~PtyReader() override;
+
+    /** Returns false if the reader thread could not be started */
+    bool isValid() const
+    {
+        return _thread != nullptr;
+    }
+
+    static qsizetype maxSliceSize();
+
+Q_SIGNALS:
+    void receivedData(const char *buffer, int length);
+
+private:
+    void readLoop();
+    void scheduleSlice();
+    void emitSlice();
+    void wakeUp();
+
+    int _fd;
+    int _wakeUpPipe[2] = {-1, -1};
+    QThread *_thread = nullptr;
+    PtyRingBuffer _buffer;
+
+    std::atomic<bool> _stopRequested = false;
+    // whether an emitSlice() call is queued
+    std::atomic<bool> _slicePending = false;
+    // whether the reader thread waits for free space
+    std::atomic<bool> _waitingForSpace = false;
+};
+}
+
+#endif // PTYREADER_H
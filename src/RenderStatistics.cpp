@@ -0,0 +1,76 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Own
+#include "RenderStatistics.h"
+
+// Qt
+#include <QStringList>
+
+Q_LOGGING_CATEGORY(KonsoleRenderStats, "org.kde.konsole.renderstats", QtInfoMsg)
+
+using namespace Konsole;
+
+void RenderStatistics::addTime(Stage stage, qint64 nsecs)
+{
+    _counters.calls[stage]++;
+    _counters.nsecs[stage] += nsecs;
+}
+
+void RenderStatistics::addFrame(int skippedFrames)
+{
+    _counters.frames++;
+    _counters.skippedFrames += skippedFrames;
+}
+
+QString RenderStatistics::toString() const
+{
+    return toString(_counters);
+}
+
+void RenderStatistics::report()
+{
+    if (!KonsoleRenderStats().isDebugEnabled()) {
+        return;
+    }
+    if (!_lastReport.isValid()) {
+        _lastReport.start();
+        _reportedCounters = _counters;
+        return;
+    }
+    if (_lastReport.elapsed() < 1000) {
+        return;
+    }
+
+    Counters counters;
+    for (int stage = 0; stage < StageCount; ++stage) {
+        counters.calls[stage] = _counters.calls[stage] - _reportedCounters.calls[stage];
+        counters.nsecs[stage] = _counters.nsecs[stage] - _reportedCounters.nsecs[stage];
+    }
+    counters.frames = _counters.frames - _reportedCounters.frames;
+    counters.skippedFrames = _counters.skippedFrames - _reportedCounters.skippedFrames;
+
+    qCDebug(KonsoleRenderStats).noquote() << "Last" << _lastReport.restart() << "ms:" << toString(counters);
+    _reportedCounters = _counters;
+}
+
+QString RenderStatistics::toString(const Counters &counters)
+{
+    static const char *const stageNames[StageCount] = {"parse", "copy image", "update image", "draw contents", "process filters"};
+
+    QStringList parts;
+    parts << QStringLiteral("frames %1 (%2 skipped)").arg(counters.frames).arg(counters.skippedFrames);
+    for (int stage = 0; stage < StageCount; ++stage) {
+        const qint64 calls = counters.calls[stage];
+        const double msecs = counters.nsecs[stage] / 1e6;
+        parts << QStringLiteral("%1 %2 ms in %3 calls (%4 ms each)")
+                     .arg(QLatin1String(stageNames[stage]))
+                     .arg(msecs, 0, 'f', 1)
+                     .arg(calls)
+                     .arg(calls > 0 ? msecs / calls : 0.0, 0, 'f', 3);
+    }
+    return parts.join(QLatin1String(", "));
+}
@@ -0,0 +1,100 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef RENDERSTATISTICS_H
+#define RENDERSTATISTICS_H
+
+// Qt
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+#include <QString>
+
+// Konsole
+#include "konsoleprivate_export.h"
+
+Q_DECLARE_LOGGING_CATEGORY(KonsoleRenderStats)
+
+namespace Konsole
+{
+/**
+ * Counts where the time of the frames of a session goes, from parsing the
+ * output of the program to painting it in the views, to find out why a
+ * terminal is slow.
+ *
+ * The statistics since the start of the session are returned by
+ * Session::renderStatistics(). While debug messages of the
+ * org.kde.konsole.renderstats category are enabled, the statistics of the
+ * last second are logged every second the session shows output.
+ */
+class KONSOLEPRIVATE_EXPORT RenderStatistics
+{
+public:
+    enum Stage {
+        Parse, ///< Decoding and parsing the output, Emulation::receiveData()
+        CopyImage, ///< Copying lines from the screen, ScreenWindow::getImage()
+        UpdateImage, ///< Finding the changed characters, TerminalDisplay::updateImage()
+        DrawContents, ///< Drawing lines, TerminalPainter::drawContents()
+        ProcessFilters, ///< Finding links and other hotspots, TerminalDisplay::processFilters()
+        StageCount,
+    };
+
+    /** Adds the time one call of @p stage took, in ns. */
+    void addTime(Stage stage, qint64 nsecs);
+    /**
+     * Adds a frame shown by the emulation, after @p skippedFrames refreshes
+     * of the screen at which output was waiting to be shown.
+     */
+    void addFrame(int skippedFrames);
+
+    /** Returns the statistics since the start of the session. */
+    QString toString() const;
+
+    /** Logs the statistics since the last report if a second has passed. */
+    void report();
+
+    /** Measures the time of a stage until it is destroyed */
+    class Timer
+    {
+    public:
+        Timer(RenderStatistics *statistics, Stage stage)
+            : _statistics(statistics)
+            , _stage(stage)
+        {
+            if (_statistics != nullptr) {
+                _timer.start();
+            }
+        }
+        ~Timer()
+        {
+            if (_statistics != nullptr) {
+                _statistics->addTime(_stage, _timer.nsecsElapsed());
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(Timer)
+
+        RenderStatistics *_statistics;
+        Stage _stage;
+        QElapsedTimer _timer;
+    };
+
+private:
+    struct Counters {
+        qint64 calls[StageCount] = {};
+        qint64 nsecs[StageCount] = {};
+        qint64 frames = 0;
+        qint64 skippedFrames = 0;
+    };
+    static QString toString(const Counters &counters);
+
+    Counters _counters;
+    Counters _reportedCounters; // _counters at the last report()
+    QElapsedTimer _lastReport;
+};
+}
+
+#endif // RENDERSTATISTICS_H
@@ -11,8 +11,6 @@
 #include <QLockFile>
 #include <QTextStream>
 
-#include <QDebug>
-
 #include <KConfig>
 #include <KConfigGroup>
 #include <KLocalizedString>
@@ -24,17 +22,49 @@
 
 namespace Konsole
 {
+bool SaveHistoryAutoWriter::open(const QString &path)
+{
+    _file.setFileName(path);
+    return _file.open(QFile::ReadWrite);
+}
+
+void SaveHistoryAutoWriter::write(qint64 position, const QByteArray &data)
+{
+    const bool success = _file.resize(position) && _file.seek(position) && _file.write(data) == data.size() && _file.flush();
+    Q_EMIT written(success);
+}
+
 QString SaveHistoryAutoTask::_saveDialogRecentURL;
 
 SaveHistoryAutoTask::SaveHistoryAutoTask(QObject *parent)
     : SessionTask(parent)
     , _droppedBytes(0)
     , _bytesLines(0)
+    , _fileSize(0)
+    , _savedLines(0)
     , _pendingChanges(false)
+    , _writer(new SaveHistoryAutoWriter)
+    , _pendingWrites(0)
 {
+    _decoder.setRecordLinePositions(true);
+    _writer->moveToThread(&_thread);
+    connect(_writer, &SaveHistoryAutoWriter::written, this, &SaveHistoryAutoTask::archiveWritten);
 }
 
-SaveHistoryAutoTask::~SaveHistoryAutoTask() = default;
+SaveHistoryAutoTask::~SaveHistoryAutoTask()
+{
+    if (_thread.isRunning()) {
+        // Quit once the pending writes are done
+        QMetaObject::invokeMethod(
+            _writer,
+            [thread = &_thread]() {
+                thread->quit();
+            },
+            Qt::QueuedConnection);
+        _thread.wait();
+    }
+    delete _writer;
+}
 
 bool SaveHistoryAutoTask::execute()
 {
@@ -82,9 +112,19 @@ bool SaveHistoryAutoTask::execute()
 
     const QString path = url.path();
 
-    _destinationFile.setFileName(path);
-
-    if (!_destinationFile.open(QFile::ReadWrite)) {
+    _fileName = path;
+
+    // The file is used by the writer thread only, so it is opened there;
+    // the destructor stops the thread if that fails
+    _thread.start();
+    bool opened = false;
+    QMetaObject::invokeMethod(
+        _writer,
+        [writer = _writer, &path, &opened]() {
+            opened = writer->open(path);
+        },
+        Qt::BlockingQueuedConnection);
+    if (!opened) {
         KMessageBox::error(nullptr, i18n("Failed to create autosave file at %1.", url.url()));
         return false;
     }
@@ -119,19 +159,14 @@ void SaveHistoryAutoTask::fileModified()
 void SaveHistoryAutoTask::linesDropped(int linesDropped)
 {
     if (linesDropped > 0) {
-        if (linesDropped > _bytesLines.count()) {
-            readLines();
-        }
-
-        if (linesDropped == _bytesLines.size()) {
-            _droppedBytes = _destinationFile.size();
+        if (linesDropped >= _bytesLines.size()) {
+            _droppedBytes = _fileSize;
+            _bytesLines.clear();
         } else {
             _droppedBytes = _bytesLines[linesDropped];
+            _bytesLines.remove(0, linesDropped);
         }
-
-        for (int i = 0; i < linesDropped; ++i) {
-            _bytesLines.pop_front();
-        }
+        _savedLines = qMax(0, _savedLines - linesDropped);
     }
 }
 
@@ -139,6 +174,8 @@ void SaveHistoryAutoTask::stop()
 {
     Q_EMIT completed(true);
     disconnect();
+    disconnect(_writer, nullptr, this, nullptr);
+    _timer.stop();
 
     if (autoDelete()) {
         deleteLater();
@@ -147,7 +184,8 @@ void SaveHistoryAutoTask::stop()
 
 void SaveHistoryAutoTask::imageResized(int /*rows*/, int /*columns*/)
 {
-    updateByteLineAnchors();
+    _savedLines = 0;
+    readLines();
 }
 
 void SaveHistoryAutoTask::linesChanged()
@@ -168,81 +206,67 @@ void SaveHistoryAutoTask::readLines()
 
     _timer.stop();
 
-    if (!updateArchive()) {
-        stop();
-        KMessageBox::error(nullptr, i18n("Failed to update autosave state on output changes."));
-        return;
-    }
-
-    updateByteLineAnchors();
+    updateArchive();
 
     _pendingChanges = false;
     _timer.start(timerInterval());
 }
 
-bool SaveHistoryAutoTask::updateArchive()
+void SaveHistoryAutoTask::updateArchive()
 {
-    _watcher.removePath(_destinationFile.fileName());
-
-    QTextStream stream(&_destinationFile);
+    Emulation *emulation = session()->emulation();
+    const int lineCount = emulation->lineCount();
 
-    if (!_destinationFile.resize(_droppedBytes) || !stream.seek(_destinationFile.size())) {
-        return false;
-    }
+    // The lines which were in the history at the last update are in the file
+    // already, only the lines after them need to be written
+    const int firstLine = qMin(_savedLines, int(_bytesLines.size()));
+    const qint64 position = firstLine < _bytesLines.size() ? _bytesLines[firstLine] : (firstLine > 0 ? _fileSize : _droppedBytes);
 
+    QString text;
+    QTextStream stream(&text);
     _decoder.begin(&stream);
-    session()->emulation()->writeToStream(&_decoder, 0, session()->emulation()->lineCount() - 1);
+    if (lineCount > firstLine) {
+        emulation->writeToStream(&_decoder, firstLine, lineCount - 1);
+    }
     _decoder.end();
     stream.flush();
 
-    if (stream.status() != QTextStream::Ok) {
-        return false;
+    // Encode the lines one by one to find where they start in the file
+    const QList<int> linePositions = _decoder.linePositions();
+    QByteArray data;
+    _bytesLines.resize(firstLine);
+    for (int i = 0; i < linePositions.size(); ++i) {
+        const int end = i + 1 < linePositions.size() ? linePositions[i + 1] : text.size();
+        _bytesLines.append(position + data.size());
+        data.append(QStringView(text).mid(linePositions[i], end - linePositions[i]).toUtf8());
     }
-
-    _watcher.addPath(_destinationFile.fileName());
-
-    return true;
+    _fileSize = position + data.size();
+    _savedLines = lineCount - emulation->imageSize().height();
+
+    // Don't take our own writes for external modifications
+    _watcher.removePath(_fileName);
+    ++_pendingWrites;
+    QMetaObject::invokeMethod(
+        _writer,
+        [writer = _writer, position, data]() {
+            writer->write(position, data);
+        },
+        Qt::QueuedConnection);
 }
 
-void SaveHistoryAutoTask::updateByteLineAnchors()
+void SaveHistoryAutoTask::archiveWritten(bool success)
 {
-    if (session().isNull()) {
+    --_pendingWrites;
+
+    if (!success) {
         stop();
+        KMessageBox::error(nullptr, i18n("Failed to update autosave state on output changes."));
         return;
     }
 
-    qint64 currentByte = _droppedBytes;
-    QList<int> lineLengths = session()->emulation()->getCurrentScreenCharacterCounts();
-
-    _bytesLines.resize(lineLengths.size());
-    _destinationFile.seek(currentByte);
-
-    for (int i = 0; i < lineLengths.size(); ++i) {
-        _bytesLines[i] = currentByte;
-        QString line;
-
-        int lineNumChars = lineLengths[i];
-
-        for (int j = 0; j < lineNumChars; ++j) {
-            char c;
-
-            if (!_destinationFile.getChar(&c)) {
-                qDebug() << "LINE " << (i + 1) << " (" << lineNumChars << ") : " << line;
-                qDebug() << "INVALID";
-                return;
-            }
-
-            line.append(QLatin1Char(c));
-        }
-
-        currentByte = _destinationFile.pos();
-        qDebug() << "LINE " << (i + 1) << " (" << lineNumChars << ") : " << line;
+    if (_pendingWrites == 0) {
+        _watcher.addPath(_fileName);
     }
-
-    if (_destinationFile.atEnd())
-        qDebug() << "VALID";
-    else
-        qDebug() << "INVALID";
 }
 
 const QPointer<Session> &SaveHistoryAutoTask::session() const
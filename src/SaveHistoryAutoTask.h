@@ -9,6 +9,7 @@
 
 #include <QFile>
 #include <QFileSystemWatcher>
+#include <QThread>
 #include <QTimer>
 
 #include "../decoders/PlainTextDecoder.h"
@@ -17,6 +18,28 @@
 
 namespace Konsole
 {
+/**
+ * Writes the autosaved output to the destination file, in the thread of a
+ * SaveHistoryAutoTask.
+ */
+class SaveHistoryAutoWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** Opens the destination file, in the thread of the writer */
+    bool open(const QString &path);
+
+    /** Truncates the file to @p position and appends @p data */
+    void write(qint64 position, const QByteArray &data);
+
+Q_SIGNALS:
+    void written(bool success);
+
+private:
+    QFile _file;
+};
+
 /**
  * A task which prompts for a URL for each session and saves that session's output
  * to the given URL
@@ -44,14 +67,14 @@ public Q_SLOTS:
 
 private Q_SLOTS:
     /**
-     * Increases _droppedBytes using info in _bytesLines when lines
-     * have been dropped from the screen and history.
+     * Moves the lines which were dropped from the screen and history
+     * to the part of the autosave file which is not rewritten anymore.
      */
     void linesDropped(int linesDropped);
 
     /**
-     * Resets _bytesLines since the lines on the screen changes when
-     * the screen is resized.
+     * Rewrites the output, since the lines of the history may be
+     * reflowed when the screen is resized.
      */
     void imageResized(int rows, int columns);
 
@@ -64,14 +87,18 @@ private Q_SLOTS:
      */
     void fileModified();
 
+    // Called when the writer thread has written a part of the output.
+    void archiveWritten(bool success);
+
 private:
     // Reads the session output.
     void readLines();
 
-    bool updateArchive();
-
-    // Updates _bytesLines.
-    void updateByteLineAnchors();
+    /**
+     * Decodes the lines which changed since the last update, and passes
+     * them to the writer thread.
+     */
+    void updateArchive();
 
     const QPointer<Session> &session() const;
 
@@ -81,8 +108,8 @@ private:
      */
     int timerInterval() const;
 
-    // File object used to store the autosaved contents.
-    QFile _destinationFile;
+    // Path of the file used to store the autosaved contents.
+    QString _fileName;
 
     /**
      * Since the autosave process relies on the files not being modified
@@ -94,12 +121,22 @@ private:
     qint64 _droppedBytes;
 
     /**
-     * A list of byte offsets in _destinationFile.
+     * A list of byte offsets in the autosave file.
      * Each offset corresponds to the first of a series of bytes
-     * containing content of a line on the emulation's current screen and history.
+     * containing content of a line on the emulation's current screen and history,
+     * as of the last update.
      */
     QList<qint64> _bytesLines;
 
+    // Size of the autosave file once the pending writes are done.
+    qint64 _fileSize;
+
+    /**
+     * Number of lines at the start of _bytesLines which were in the history
+     * at the last update.  They can't change anymore, so they are not rewritten.
+     */
+    int _savedLines;
+
     PlainTextDecoder _decoder;
 
     // Used to time how often the output should be re-read.
@@ -111,6 +148,11 @@ private:
      */
     bool _pendingChanges;
 
+    // The file is written in another thread, so that slow storage doesn't block the UI.
+    QThread _thread;
+    SaveHistoryAutoWriter *_writer;
+    int _pendingWrites;
+
     static QString _saveDialogRecentURL;
 };
 
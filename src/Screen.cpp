@@ -58,6 +58,10 @@ const Character Screen::DefaultChar = Character(' ',
 const Character Screen::VisibleChar =
     Character(' ', CharacterColor(COLOR_SPACE_DEFAULT, DEFAULT_FORE_COLOR), CharacterColor(COLOR_SPACE_DEFAULT, DEFAULT_BACK_COLOR), DEFAULT_RENDITION, 0);
 
+// Last generation given to a line, see Screen::lineGeneration().  It is shared by
+// all screens, so that the lines of different screens have different generations.
+static quint64 lastLineGeneration = 0;
+
 Screen::Screen(int lines, int columns)
     : _currentTerminalDisplay(nullptr)
     , _lines(lines)
@@ -72,6 +76,7 @@ Screen::Screen(int lines, int columns)
     , _isResize(false)
     , _enableReflowLines(false)
     , _lineProperties(_lines + 1)
+    , _lineGenerations(_lines + 1, 0)
     , _history(std::make_unique<HistoryScrollNone>())
     , _cuX(0)
     , _cuY(0)
@@ -372,6 +377,7 @@ void Screen::eraseBlock(int y, int x, int height, int width)
     height = qBound(0, height, _lines - y - 1);
     Character chr(' ', CharacterColor(COLOR_SPACE_DEFAULT, DEFAULT_FORE_COLOR), CharacterColor(COLOR_SPACE_DEFAULT, DEFAULT_BACK_COLOR), RE_TRANSPARENT, 0);
     for (int row = y; row < y + height; row++) {
+        markLineDirty(row);
         QVector<Character> &line = _screenLines[row];
         if (line.size() < endCol + 1) {
             line.resize(endCol + 1);
@@ -406,6 +412,7 @@ void Screen::deleteChars(int n)
     Q_ASSERT(n >= 0);
     Q_ASSERT(_cuX + n <= _screenLines.at(_cuY).count());
 
+    markLineDirty(_cuY);
     _screenLines[_cuY].remove(_cuX, n);
 
     // Append space(s) with current attributes
@@ -422,6 +429,7 @@ void Screen::insertChars(int n)
         n = 1; // Default
     }
 
+    markLineDirty(_cuY);
     if (_screenLines.at(_cuY).size() < _cuX) {
         _screenLines[_cuY].resize(_cuX);
     }
@@ -482,6 +490,9 @@ void Screen::setMode(int m)
         _cuX = 0;
         _cuY = _topMargin;
         break; // FIXME: home
+    case MODE_Screen:
+        markAllLinesDirty();
+        break;
     }
 }
 
@@ -493,6 +504,9 @@ void Screen::resetMode(int m)
         _cuX = 0;
         _cuY = 0;
         break; // FIXME: home
+    case MODE_Screen:
+        markAllLinesDirty();
+        break;
     }
 }
 
@@ -504,6 +518,9 @@ void Screen::saveMode(int m)
 void Screen::restoreMode(int m)
 {
     _currentModes[m] = _savedModes[m];
+    if (m == MODE_Screen) {
+        markAllLinesDirty();
+    }
 }
 
 bool Screen::getMode(int m) const
@@ -625,6 +642,7 @@ void Screen::resizeImage(int new_lines, int new_columns)
         }
         std::map<int, int> deltas = {};
         auto removedLines = _history->reflowLines(new_columns, &deltas);
+        historyReset();
 
         // If _history size > max history size it will drop a line from _history.
         // We need to verify if we need to remove a URL.
@@ -716,6 +734,7 @@ void Screen::resizeImage(int new_lines, int new_columns)
             _screenLines.insert(_screenLines.begin(), std::move(histLine));
             _lineProperties.insert(_lineProperties.begin(), lineProperty);
             _history->removeCells();
+            historyReset();
             ++cursorLine;
             scrollPlacements(-1);
         }
@@ -726,6 +745,7 @@ void Screen::resizeImage(int new_lines, int new_columns)
         std::fill(_lineProperties.begin() + _screenLines.size(), _lineProperties.end(), LineProperty());
     }
     _screenLines.resize(new_lines + 1);
+    _lineGenerations.assign(new_lines + 1, 0);
 
     _screenLinesSize = new_lines;
     _lines = new_lines;
@@ -908,8 +928,8 @@ void Screen::getImage(Character *dest, int size, int startLine, int endLine) con
 
     int visX = qMin(_cuX, getScreenLineColumns(_cuY) - 1);
     // mark the character at the current cursor position
-    int cursorIndex = loc(visX, _cuY + linesInHistoryBuffer);
-    if (getMode(MODE_Cursor) && cursorIndex < _columns * mergedLines) {
+    int cursorIndex = loc(visX, _cuY + _history->getLines() - startLine);
+    if (getMode(MODE_Cursor) && cursorIndex >= 0 && cursorIndex < _columns * mergedLines) {
         dest[cursorIndex].rendition.f.cursor = 1;
     }
     cursorIndex = loc(_selCuX, _selCuY - startLine + _history->getLines());
@@ -919,6 +939,28 @@ void Screen::getImage(Character *dest, int size, int startLine, int endLine) con
     }
 }
 
+quint64 Screen::lineGeneration(int line) const
+{
+    const int screenLine = line - _history->getLines();
+
+    // The image of the history lines is not tracked, and the image of the
+    // cursor line and of the selection depends on more than the characters
+    if (screenLine < 0 || screenLine >= _lines || screenLine == _cuY || _selBegin != -1 || getMode(MODE_SelectCursor)) {
+        return 0;
+    }
+
+    quint64 &generation = _lineGenerations[screenLine];
+    if (generation == 0) {
+        generation = ++lastLineGeneration;
+    }
+    return generation;
+}
+
+void Screen::markAllLinesDirty()
+{
+    std::fill(_lineGenerations.begin(), _lineGenerations.end(), 0);
+}
+
 QVector<LineProperty> Screen::getLineProperties(int startLine, int endLine) const
 {
     Q_ASSERT(startLine >= 0);
@@ -1012,6 +1054,7 @@ void Screen::backspace()
     _cuX = qMax(0, _cuX - 1);
 
     if (_screenLines.at(_cuY).size() < _cuX + 1) {
+        markLineDirty(_cuY);
         _screenLines[_cuY].resize(_cuX + 1);
     }
 }
@@ -1095,6 +1138,16 @@ void Screen::checkSelection(int from, int to)
     }
 }
 
+// Word flags of a printable, non-space ASCII character
+static inline ExtraFlags asciiWordFlags(uint c)
+{
+    if (c == '!' || c == '#' || c == '$' || c == '%' || c == '(' || c == ')' || c == '*' || c == '+' || c == '-' || c == '.' || c == '/' || c == ':'
+        || c == '<' || c == '=' || c == '>' || c == '?' || c == '[' || c == ']' || c == '^' || c == '_' || c == '{' || c == '|' || c == '}' || c == '~') {
+        return EF_ASCII_WORD | EF_CODING_WORD;
+    }
+    return EF_ASCII_WORD;
+}
+
 void Screen::displayCharacter(uint c)
 {
     // Note that VT100 does wrapping BEFORE putting the character.
@@ -1148,6 +1201,8 @@ void Screen::displayCharacter(uint c)
             }
         }
 
+        markLineDirty(charToCombineWithY);
+        markLineDirty(_cuY);
         Character &currentChar = _screenLines[charToCombineWithY][charToCombineWithX];
 
         if (c == 0x20E3) {
@@ -1220,6 +1275,10 @@ void Screen::displayCharacter(uint c)
             goto notcombine;
         }
 
+        if (Character::bidi(c)) {
+            currentChar.flags |= EF_BIDI;
+        }
+
         if (currentChar.rendition.f.extended == 0) {
             const char32_t chars[2] = {currentChar.character, c};
             currentChar.rendition.f.extended = 1;
@@ -1269,6 +1328,8 @@ notcombine:
         }
     }
 
+    markLineDirty(_cuY);
+
     // ensure current line vector has enough elements
     if (_screenLines[_cuY].size() < _cuX + w) {
         _screenLines[_cuY].resize(_cuX + w);
@@ -1315,11 +1376,7 @@ notcombine:
         currentChar.flags |= EF_EMOJI_REPRESENTATION;
     }
     if (c <= '~' && c > ' ') {
-        currentChar.flags |= EF_ASCII_WORD;
-        if (c == '!' || c == '#' || c == '$' || c == '%' || c == '(' || c == ')' || c == '*' || c == '+' || c == '-' || c == '.' || c == '/' || c == ':'
-            || c == '<' || c == '=' || c == '>' || c == '?' || c == '[' || c == ']' || c == '^' || c == '_' || c == '{' || c == '|' || c == '}' || c == '~') {
-            currentChar.flags |= EF_CODING_WORD;
-        }
+        currentChar.flags |= asciiWordFlags(c);
     }
     if (c >= 0x900
         && (c <= 0x109f || (c >= 0x1700 && c <= 0x18af) || (c >= 0x1900 && c <= 0x1aaf) || (c >= 0x1b00 && c <= 0x1c4f) || (c >= 0xa800 && c <= 0xa82f)
@@ -1327,6 +1384,9 @@ notcombine:
             || (c >= 0x11000 && c <= 0x11fff))) {
         currentChar.flags |= EF_BRAHMIC_WORD;
     }
+    if (Character::bidi(c)) {
+        currentChar.flags |= EF_BIDI;
+    }
 
     _lastDrawnChar = c;
 
@@ -1361,6 +1421,74 @@ notcombine:
     }
 }
 
+void Screen::displayRun(const uint *chars, int count)
+{
+    // Inserting shifts the rest of the line for every character and graphics
+    // placements are cleared cell by cell, so leave those to displayCharacter()
+    if (getMode(MODE_Insert) || _hasGraphics) {
+        for (int i = 0; i < count; ++i) {
+            displayCharacter(chars[i]);
+        }
+        return;
+    }
+
+    const ExtraFlags baseFlags = setRepl(EF_REAL, _replMode) | SetULColor(0, _currentULColor);
+
+    while (count > 0) {
+        // Same wrapping rules as displayCharacter() for a single column character
+        if (_cuX + 1 > getScreenLineColumns(_cuY)) {
+            if (getMode(MODE_Wrap)) {
+                _lineProperties[_cuY].flags.f.wrapped = 1;
+                nextLine();
+            } else {
+                _cuX = qMax(getScreenLineColumns(_cuY) - 1, 0);
+            }
+        }
+
+        const int n = qMin(count, qMax(getScreenLineColumns(_cuY) - _cuX, 1));
+        markLineDirty(_cuY);
+
+        // ensure current line vector has enough elements
+        if (_screenLines[_cuY].size() < _cuX + n) {
+            _screenLines[_cuY].resize(_cuX + n);
+        }
+
+        const int firstPos = loc(_cuX, _cuY);
+        _lastPos = firstPos + n - 1;
+
+        // check if selection is still valid.
+        checkSelection(firstPos, _lastPos);
+
+        Character *cell = _screenLines[_cuY].data() + _cuX;
+        for (int i = 0; i < n; ++i) {
+            const uint c = chars[i];
+            cell[i].character = c;
+            cell[i].foregroundColor = _effectiveForeground;
+            cell[i].backgroundColor = _effectiveBackground;
+            cell[i].rendition = _effectiveRendition;
+            cell[i].flags = c != ' ' ? baseFlags | asciiWordFlags(c) : baseFlags;
+        }
+
+        _lastDrawnChar = chars[n - 1];
+        _cuX += n;
+        if (_replMode != REPL_None && std::make_pair(_cuY, _cuX) >= _replModeEnd) {
+            _replModeEnd = std::make_pair(_cuY, _cuX);
+        }
+        if (_lineProperties[_cuY].length < _cuX) {
+            _lineProperties[_cuY].length = _cuX;
+        }
+
+        if (_escapeSequenceUrlExtractor) {
+            for (int i = 0; i < n; ++i) {
+                _escapeSequenceUrlExtractor->appendUrlText(chars[i]);
+            }
+        }
+
+        chars += n;
+        count -= n;
+    }
+}
+
 int Screen::scrolledLines() const
 {
     return _scrolledLines;
@@ -1545,6 +1673,7 @@ void Screen::clearImage(int loca, int loce, char c, bool resetLineRendition)
             }
         }
 
+        markLineDirty(y);
         QVector<Character> &line = _screenLines[y];
 
         if (isDefaultCh && endCol == _columns - 1) {
@@ -1623,11 +1752,15 @@ void Screen::moveImage(int dest, int sourceBegin, int sourceEnd)
         _screenLines.erase(_screenLines.begin() + destY, _screenLines.begin() + srcY);
 
         std::rotate(_lineProperties.begin() + destY, _lineProperties.begin() + srcY, _lineProperties.begin() + srcY + lines);
+        std::rotate(_lineGenerations.begin() + destY, _lineGenerations.begin() + srcY, _lineGenerations.begin() + srcY + lines);
     } else {
         for (int i = lines; i >= 0; --i) {
             _screenLines[destY + i] = std::move(_screenLines[srcY + i]);
             _lineProperties[destY + i] = _lineProperties.at(srcY + i);
+            _lineGenerations[destY + i] = _lineGenerations.at(srcY + i);
         }
+        // the lines moved from are left empty
+        std::fill(_lineGenerations.begin() + srcY, _lineGenerations.begin() + qMin(destY, srcY + lines + 1), 0);
     }
 
     if (_lastPos != -1) {
@@ -2382,9 +2515,11 @@ void Screen::writeLinesToStream(TerminalCharacterDecoder *decoder, int fromLine,
 
 void Screen::fastAddHistLine()
 {
-    const bool removeLine = _history->getLines() == _history->getMaxLines();
+    const int oldHistoryLines = _history->getLines();
+    const bool removeLine = oldHistoryLines == _history->getMaxLines();
     _history->addCellsVector(_screenLines.at(0));
     _history->addLine(linePropertiesAt(0));
+    historyLineAdded(_screenLines.at(0), linePropertiesAt(0), oldHistoryLines);
 
     // If _history size > max history size it will drop a line from _history.
     // We need to verify if we need to remove a URL.
@@ -2402,6 +2537,8 @@ void Screen::fastAddHistLine()
     std::fill(last.begin(), last.end(), clearCh);
 
     _lineProperties.erase(_lineProperties.begin());
+    std::rotate(_lineGenerations.begin(), _lineGenerations.begin() + 1, _lineGenerations.end());
+    markLineDirty(_lineGenerations.size() - 1);
 }
 
 void Screen::addHistLine()
@@ -2434,6 +2571,7 @@ void Screen::addHistLine()
             }
         }
     }
+    historyLineAdded(_screenLines.at(0), _lineProperties.at(0), oldHistLines);
 
     bool beginIsTL = (_selBegin == _selTopLeft);
 
@@ -2478,9 +2616,59 @@ int Screen::getHistLines() const
     return _history->getLines();
 }
 
+void Screen::historyLineAdded(const ImageLine &line, LineProperty lineProperty, int oldHistoryLines)
+{
+    // If the history is full, or there is none, lines were dropped
+    const int droppedLines = oldHistoryLines + 1 - _history->getLines();
+    if (droppedLines > 0) {
+        _totalDroppedLines += droppedLines;
+    }
+
+    if (_searchIndex.isValid()) {
+        // While the index is built, it holds the first lines of the history,
+        // and updateHistorySearchIndex() adds this line later
+        if (_searchIndex.lineCount() == oldHistoryLines) {
+            _searchIndex.addLine(line.constData(), line.size(), lineProperty);
+        }
+        if (droppedLines > 0) {
+            _searchIndex.removeFirstLines(droppedLines);
+        }
+    }
+}
+
+void Screen::historyReset()
+{
+    _searchIndex.invalidate();
+    ++_historyResets;
+}
+
+bool Screen::updateHistorySearchIndex(int maxLines)
+{
+    const int lines = _history->getLines();
+    if (!_searchIndex.isValid() || _searchIndex.lineCount() > lines) {
+        _searchIndex.clear();
+    }
+
+    ImageLine line;
+    const int end = qMin(lines, _searchIndex.lineCount() + maxLines);
+    for (int i = _searchIndex.lineCount(); i < end; ++i) {
+        const int length = _history->getLineLen(i);
+        line.resize(length);
+        _history->getCells(i, 0, length, line.data());
+        _searchIndex.addLine(line.constData(), length, _history->getLineProperty(i));
+    }
+    return _searchIndex.lineCount() == lines;
+}
+
+const HistorySearchIndex &Screen::historySearchIndex() const
+{
+    return _searchIndex;
+}
+
 void Screen::setScroll(const HistoryType &t, bool copyPreviousScroll)
 {
     clearSelection();
+    historyReset();
 
     if (copyPreviousScroll) {
         t.scroll(_history);
@@ -21,6 +21,7 @@
 
 // Konsole
 #include "characters/Character.h"
+#include "history/HistorySearchIndex.h"
 #include "konsoleprivate_export.h"
 
 #define MODE_Origin 0
@@ -407,6 +408,16 @@ public:
      */
     void displayCharacter(uint c);
 
+    /**
+     * Displays a run of @p count characters starting at the current cursor
+     * position.  This is equivalent to calling displayCharacter() for each
+     * character in @p chars, but writes the cells of a line in one pass.
+     *
+     * All characters in the run must be printable ASCII (0x20 to 0x7E), which
+     * have a width of one column and never combine with the previous character.
+     */
+    void displayRun(const uint *chars, int count);
+
     /**
      * Resizes the image to a new fixed size of @p new_lines by @p new_columns.
      * In the case that @p new_columns is smaller than the current number of columns,
@@ -467,6 +478,55 @@ public:
      */
     bool hasScroll() const;
 
+    /**
+     * Adds at most @p maxLines lines of the history to historySearchIndex(),
+     * so that the index can be built in slices between other events, and
+     * returns true once the index holds all the lines of the history.  It is
+     * then kept up to date as lines are added to the history.
+     */
+    bool updateHistorySearchIndex(int maxLines);
+
+    /**
+     * Returns an index of the text of the history, used to find the lines of
+     * the history which may contain a string.  Only holds all the lines of
+     * the history once updateHistorySearchIndex() returned true.
+     */
+    const HistorySearchIndex &historySearchIndex() const;
+
+    /**
+     * Returns the generation of @p line, which changes whenever the image of
+     * the line returned by getImage() may change.  A line moved by scrolling
+     * keeps its generation, and lines of different screens never have the same
+     * generation, so a line whose generation is the same as the one of a line
+     * copied earlier doesn't need to be copied again.
+     *
+     * Returns 0 when the image of the line is not tracked, in which case it
+     * may change at any time: for the lines of the history, the cursor line,
+     * and for all lines while there is a selection.
+     */
+    quint64 lineGeneration(int line) const;
+
+    /**
+     * Returns the number of lines which were dropped from the start of the
+     * output since the screen was created, either from a full history or
+     * from the screen when there is no history.  Adding it to a line number
+     * gives a number which does not change as lines are dropped.
+     */
+    qint64 totalDroppedLines() const
+    {
+        return _totalDroppedLines;
+    }
+
+    /**
+     * Returns a number which changes whenever the lines of the history are
+     * changed, other than by adding lines at the end or dropping them from
+     * the start, for example when they are reflowed.
+     */
+    int historyResets() const
+    {
+        return _historyResets;
+    }
+
     /**
      * Sets the start of the selection.
      *
@@ -817,8 +877,25 @@ private:
     std::vector<LineProperty> _lineProperties;
     LineProperty linePropertiesAt(unsigned int line);
 
+    // Generation of each line of _screenLines, 0 if it changed since its generation
+    // was last returned by lineGeneration(), which then gives it a new one
+    mutable std::vector<quint64> _lineGenerations;
+    void markLineDirty(int line)
+    {
+        _lineGenerations[line] = 0;
+    }
+    void markAllLinesDirty();
+
     // history buffer ---------------
     std::unique_ptr<HistoryScroll> _history;
+    HistorySearchIndex _searchIndex;
+    qint64 _totalDroppedLines = 0;
+    int _historyResets = 0;
+    // updates _searchIndex and _totalDroppedLines after 'line' was added to the history,
+    // which had 'oldHistoryLines' lines before
+    void historyLineAdded(const ImageLine &line, LineProperty lineProperty, int oldHistoryLines);
+    // to be called when the history lines were changed by other means
+    void historyReset();
 
     // cursor location
     int _cuX;
@@ -48,6 +48,26 @@ Screen *ScreenWindow::screen() const
     return _screen;
 }
 
+void ScreenWindow::setRenderStatistics(RenderStatistics *statistics)
+{
+    _renderStatistics = statistics;
+}
+
+RenderStatistics *ScreenWindow::renderStatistics() const
+{
+    return _renderStatistics;
+}
+
+void ScreenWindow::setRefreshRate(qreal refreshRate)
+{
+    _refreshRate = refreshRate;
+}
+
+qreal ScreenWindow::refreshRate() const
+{
+    return _refreshRate;
+}
+
 Character *ScreenWindow::getImage()
 {
     // reallocate internal buffer if the window size has changed
@@ -57,23 +77,66 @@ Character *ScreenWindow::getImage()
         _windowBufferSize = size;
         _windowBuffer = new Character[size];
         _bufferNeedsUpdate = true;
+        _frame.lineGenerations.clear();
+    }
+    if (_frame.lineGenerations.size() != windowLines()) {
+        // the same size with another number of lines
+        _frame.lineGenerations.fill(0, windowLines());
+        _bufferNeedsUpdate = true;
     }
 
     if (!_bufferNeedsUpdate) {
         return _windowBuffer;
     }
 
-    _screen->getImage(_windowBuffer, size, currentLine(), endWindowLine());
+    RenderStatistics::Timer timer(_renderStatistics, RenderStatistics::CopyImage);
+
+    // only copy the runs of lines which changed since they were copied
+    // to the buffer, see Screen::lineGeneration()
+    const int firstLine = currentLine();
+    const int lastLine = endWindowLine();
+    const int columns = windowColumns();
+    int changedLine = -1;
+    for (int line = firstLine; line <= lastLine; ++line) {
+        const quint64 generation = _screen->lineGeneration(line);
+        quint64 &bufferGeneration = _frame.lineGenerations[line - firstLine];
+        const bool changed = (generation == 0 || generation != bufferGeneration);
+        bufferGeneration = generation;
+
+        if (changed && changedLine == -1) {
+            changedLine = line;
+        } else if (!changed && changedLine != -1) {
+            const int offset = (changedLine - firstLine) * columns;
+            _screen->getImage(_windowBuffer + offset, size - offset, changedLine, line - 1);
+            changedLine = -1;
+        }
+    }
+    if (changedLine != -1) {
+        const int offset = (changedLine - firstLine) * columns;
+        _screen->getImage(_windowBuffer + offset, size - offset, changedLine, lastLine);
+    }
+    std::fill(_frame.lineGenerations.begin() + (lastLine - firstLine + 1), _frame.lineGenerations.end(), 0);
 
     // this window may look beyond the end of the screen, in which
     // case there will be an unused area which needs to be filled
     // with blank characters
     fillUnusedArea();
 
+    _frame.image = _windowBuffer;
+    _frame.lines = windowLines();
+    _frame.columns = columns;
+    _frame.lineProperties = getLineProperties();
+
     _bufferNeedsUpdate = false;
     return _windowBuffer;
 }
 
+const ScreenWindow::Frame &ScreenWindow::frame()
+{
+    getImage();
+    return _frame;
+}
+
 void ScreenWindow::fillUnusedArea()
 {
     int screenEndLine = _screen->getHistLines() + _screen->getLines() - 1;
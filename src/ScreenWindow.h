@@ -13,6 +13,7 @@
 #include <QRect>
 
 // Konsole
+#include "RenderStatistics.h"
 #include "Screen.h"
 #include "characters/Character.h"
 #include "konsoleprivate_export.h"
@@ -58,6 +59,19 @@ public:
     /** Returns the screen which this window looks onto */
     Screen *screen() const;
 
+    /** Sets the statistics which the time spent showing this window is added to */
+    void setRenderStatistics(RenderStatistics *statistics);
+    /** Returns the statistics set with setRenderStatistics(), or nullptr */
+    RenderStatistics *renderStatistics() const;
+
+    /**
+     * Sets the refresh rate in Hz of the screen which this window is shown
+     * on, or 0 if it isn't shown.  See Emulation::refreshInterval()
+     */
+    void setRefreshRate(qreal refreshRate);
+    /** Returns the refresh rate set with setRefreshRate() */
+    qreal refreshRate() const;
+
     /**
      * Returns the image of characters which are currently visible through this window
      * onto the screen.
@@ -67,6 +81,31 @@ public:
      */
     Character *getImage();
 
+    /** What is visible through the window, see frame() */
+    struct Frame {
+        const Character *image = nullptr; ///< lines * columns characters, see getImage()
+        int lines = 0;
+        int columns = 0;
+        QVector<LineProperty> lineProperties;
+        /// generation of each line, or 0 for the lines which are not tracked, see Screen::lineGeneration()
+        QVector<quint64> lineGenerations;
+    };
+
+    /**
+     * Returns the characters and line properties which are currently visible
+     * through this window.
+     *
+     * Only the lines which changed since the last frame are copied from the
+     * screen, and the frame stays the same until the screen or the window
+     * changes, so that the display and its filters can use the same frame
+     * instead of copying from the screen for each of them.
+     *
+     * The frame is not a snapshot: its image is the buffer of getImage(),
+     * which the next call to getImage() or frame() overwrites, so it must
+     * only be used on the thread of the screen and not be kept around.
+     */
+    const Frame &frame();
+
     /**
      * Returns the line attributes associated with the lines of characters which
      * are currently visible through this window
@@ -266,6 +305,9 @@ private:
     Character *_windowBuffer;
     int _windowBufferSize;
     bool _bufferNeedsUpdate;
+    Frame _frame; // the image is _windowBuffer
+    RenderStatistics *_renderStatistics = nullptr;
+    qreal _refreshRate = 0;
 
     int _windowLines;
     int _currentLine; // see scrollTo() , currentLine()
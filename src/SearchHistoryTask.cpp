@@ -7,14 +7,53 @@
 
 #include "SearchHistoryTask.h"
 
-#include <QApplication>
+#include <QCoreApplication>
 #include <QTextStream>
+#include <QThreadPool>
+
+#include <algorithm>
 
 #include "../decoders/PlainTextDecoder.h"
-#include "Emulation.h"
+#include "Screen.h"
 
 namespace Konsole
 {
+// Number of lines decoded, or added to the search index, at once on the GUI thread
+static const int SLICE_LINES = 2000;
+// Number of decoded slices waiting for the thread pool, at most
+static const int MAX_PENDING_SLICES = 4;
+// Interval between updates of the search results, in ms
+static const int REPORT_INTERVAL = 100;
+
+// Searches @p text, which holds the lines starting at @p firstLine, whose
+// positions in @p text are @p linePositions, and returns the lines up to
+// @p lastLine where a match starts.  Returns early once @p stopped is set.
+static QList<qint64> searchText(const QRegularExpression &regExp,
+                                const QString &text,
+                                const QList<int> &linePositions,
+                                qint64 firstLine,
+                                qint64 lastLine,
+                                const std::atomic<bool> &stopped)
+{
+    QList<qint64> lines;
+    QRegularExpressionMatchIterator matchIterator = regExp.globalMatch(text);
+    while (matchIterator.hasNext() && !stopped) {
+        const QRegularExpressionMatch match = matchIterator.next();
+        const auto lineMatch = std::upper_bound(linePositions.begin(), linePositions.end(), match.capturedStart());
+        if (lineMatch == linePositions.begin()) {
+            continue;
+        }
+        const qint64 line = firstLine + std::distance(linePositions.begin(), lineMatch) - 1;
+        if (line > lastLine) {
+            break;
+        }
+        if (lines.isEmpty() || lines.last() != line) {
+            lines.append(line);
+        }
+    }
+    return lines;
+}
+
 void SearchHistoryTask::addScreenWindow(Session *session, ScreenWindow *searchWindow)
 {
     _windows.insert(session, searchWindow);
@@ -22,188 +61,362 @@ void SearchHistoryTask::addScreenWindow(Session *session, ScreenWindow *searchWi
 
 bool SearchHistoryTask::execute()
 {
-    auto iter = QMapIterator<QPointer<Session>, ScreenWindowPtr>(_windows);
+    _pendingSessions = _windows.keys();
+    startNextWindow();
+    return true;
+}
 
-    while (iter.hasNext()) {
-        iter.next();
-        executeOnScreenWindow(iter.key(), iter.value());
-    }
+void SearchHistoryTask::cancel()
+{
+    _cancelled = true;
+    _sliceTimer.stop();
+    _stopped->store(true);
 
     if (autoDelete()) {
         deleteLater();
     }
-    return true;
 }
 
-void SearchHistoryTask::executeOnScreenWindow(const QPointer<Session> &session, const ScreenWindowPtr &window)
+void SearchHistoryTask::startNextWindow()
 {
-    Q_ASSERT(session);
-    Q_ASSERT(window);
+    while (!_pendingSessions.isEmpty()) {
+        _session = _pendingSessions.takeFirst();
+        _window = _windows.value(_session);
 
-    Emulation *emulation = session->emulation();
+        if (_regExp.pattern().isEmpty() || !_session || !_window) {
+            Q_EMIT completed(false);
+            continue;
+        }
+
+        _found = false;
+        startSearch();
+        return;
+    }
+
+    if (autoDelete()) {
+        deleteLater();
+    }
+}
 
-    if (!_regExp.pattern().isEmpty()) {
-        bool forwards = (_direction == Enum::ForwardsSearch);
-        const int lastLine = window->lineCount() - 1;
+// Returns true if @p regExp matches a fixed string, which is stored in @p text,
+// as for the patterns made by QRegularExpression::escape()
+static bool isLiteral(const QRegularExpression &regExp, QString &text)
+{
+    if (regExp.patternOptions() & QRegularExpression::ExtendedPatternSyntaxOption) {
+        return false;
+    }
 
-        int startLine = _startLine;
-        if (forwards && (_startLine == lastLine)) {
-            if (!_noWrap) {
-                startLine = 0;
+    static const QString metaCharacters = QStringLiteral("\\^$.|?*+()[]{}");
+    const QString pattern = regExp.pattern();
+    text.clear();
+    text.reserve(pattern.size());
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        QChar c = pattern.at(i);
+        if (c == QLatin1Char('\\')) {
+            if (++i == pattern.size()) {
+                return false;
             }
-        } else if (!forwards && (_startLine == 0)) {
-            if (!_noWrap) {
-                startLine = lastLine;
+            // Escaped ASCII letters and digits are character classes, assertions etc.
+            c = pattern.at(i);
+            if (c.unicode() < 0x80 && (c.isLetterOrNumber() || c == QLatin1Char('_'))) {
+                return false;
             }
+        } else if (metaCharacters.contains(c)) {
+            return false;
+        }
+        text.append(c);
+    }
+    return true;
+}
+
+void SearchHistoryTask::startSearch()
+{
+    _screen = _window->screen();
+    _historyResets = _screen->historyResets();
+    _matches.clear();
+    _phase = 0;
+    _reportTimer.start();
+
+    ++_generation;
+    _pendingSlices = 0;
+    _slicesStarted = 0;
+    _slicesProcessed = 0;
+    _sliceResults.clear();
+
+    const qint64 dropped = _screen->totalDroppedLines();
+    const int lastLine = _window->lineCount() - 1;
+
+    // Ranges of lines to search, using the search index to skip the parts of
+    // the history which can't contain a match when searching for a string
+    QList<QPair<int, int>> ranges;
+    QString text;
+    // The index is built in slices while searching, see searchSlices(), and
+    // only used once it is complete
+    if (isLiteral(_regExp, text) && _screen->updateHistorySearchIndex(SLICE_LINES)) {
+        const HistorySearchIndex &index = _screen->historySearchIndex();
+        ranges = index.candidateLines(text);
+        // The screen lines are not indexed, nor is the end of the history if
+        // it wraps into them
+        ranges.append({index.openLineStart(), lastLine});
+    } else {
+        ranges.append({0, lastLine});
+    }
+
+    _ranges.clear();
+    for (const auto &[first, last] : std::as_const(ranges)) {
+        if (first > last) {
+            continue;
+        }
+        if (!_ranges.isEmpty() && dropped + first <= _ranges.last().second + 1) {
+            _ranges.last().second = qMax(_ranges.last().second, dropped + last);
         } else {
-            startLine = _startLine + (forwards ? 1 : -1);
+            _ranges.append({dropped + first, dropped + last});
         }
+    }
 
-        QString string;
-
-        // text stream to read history into string for pattern or regular expression searching
-        QTextStream searchStream(&string);
-
-        PlainTextDecoder decoder;
-        decoder.setRecordLinePositions(true);
-
-        // setup first and last lines depending on search direction
-        int line = startLine;
-
-        // read through and search history in blocks of 10K lines.
-        // this balances the need to retrieve lots of data from the history each time
-        //(for efficient searching)
-        // without using silly amounts of memory if the history is very large.
-        const int maxDelta = qMin(window->lineCount(), 10000);
-        int delta = forwards ? maxDelta : -maxDelta;
-
-        int endLine = line;
-        bool continueLoop = true;
-        bool invertDirection = false;
-        bool hasWrapped = false; // set to true when we reach the top/bottom
-        // of the output and continue from the other
-        // end
-
-        QSet<int> matchPositions;
-
-        decoder.begin(&searchStream);
-        emulation->writeToStream(&decoder, 0, lastLine);
-        decoder.end();
-        const QList<int> linePositions = decoder.linePositions();
-
-        QRegularExpressionMatchIterator matchIterator = _regExp.globalMatch(string);
-        while (matchIterator.hasNext()) {
-            const QRegularExpressionMatch match = matchIterator.next();
-            const qsizetype startPos = match.capturedStart();
-            if (startPos != -1) {
-                const auto lineMatch = std::upper_bound(linePositions.begin(), linePositions.end(), startPos);
-                if (lineMatch != linePositions.end()) {
-                    const auto lineIdx = qMin(0ll, lastLine) + std::distance(linePositions.begin(), lineMatch) - 1;
-                    matchPositions.insert(static_cast<int>(lineIdx));
-                }
-            }
+    const bool forwards = (_direction == Enum::ForwardsSearch);
+    int startLine = _startLine;
+    if (forwards && (_startLine == lastLine)) {
+        if (!_noWrap) {
+            startLine = 0;
+        }
+    } else if (!forwards && (_startLine == 0)) {
+        if (!_noWrap) {
+            startLine = lastLine;
         }
+    } else {
+        startLine = _startLine + (forwards ? 1 : -1);
+    }
 
-        Q_EMIT searchResults(matchPositions, window->lineCount());
+    // Search from the start line to the end of the output in the search
+    // direction, then wrap around to the other end, or if noWrap is set,
+    // go back from the start line in the other direction
+    const qint64 start = dropped + startLine;
+    const qint64 first = dropped;
+    const qint64 last = dropped + lastLine;
+    _phases.clear();
+    if (forwards) {
+        _phases.append({start, last, true});
+        _phases.append(_noWrap ? Phase{start - 1, first, false} : Phase{first, start - 1, true});
+    } else {
+        _phases.append({start, first, false});
+        _phases.append(_noWrap ? Phase{start + 1, last, true} : Phase{last, start + 1, false});
+    }
+    _cursor = _phases.at(0).from;
 
-        string.clear();
+    _sliceTimer.start();
+}
 
-        // loop through history in blocks of <delta> lines.
-        do {
-            // ensure that application does not appear to hang
-            // if searching through a lengthy output
-            QApplication::processEvents();
+bool SearchHistoryTask::isWrapped(qint64 line) const
+{
+    const int screenLine = line - _screen->totalDroppedLines();
+    return _screen->getLineProperties(screenLine, screenLine).at(0).flags.f.wrapped != 0;
+}
 
-            // calculate lines to search in this iteration
-            if (hasWrapped) {
-                if (endLine == lastLine) {
-                    line = 0;
-                } else if (endLine == 0) {
-                    line = lastLine;
+bool SearchHistoryTask::nextSlice(qint64 &first, qint64 &last)
+{
+    const qint64 dropped = _screen->totalDroppedLines();
+    const qint64 lastLine = dropped + _screen->getHistLines() + _screen->getLines() - 1;
+
+    while (_phase < _phases.size()) {
+        const Phase &phase = _phases.at(_phase);
+        if (phase.ascending) {
+            _cursor = qMax(_cursor, dropped);
+            const auto range = std::lower_bound(_ranges.cbegin(), _ranges.cend(), _cursor, [](const QPair<qint64, qint64> &r, qint64 line) {
+                return r.second < line;
+            });
+            if (_cursor <= phase.to && range != _ranges.cend() && range->first <= phase.to) {
+                first = qMax(_cursor, range->first);
+                last = qMin(qMin(range->second, phase.to), first + SLICE_LINES - 1);
+                // Don't split logical lines between slices
+                while (last < lastLine && isWrapped(last)) {
+                    ++last;
                 }
-
-                endLine += delta;
-
-                if (forwards) {
-                    if (endLine >= startLine) {
-                        endLine = startLine;
-                        continueLoop = false;
-                    }
-                } else {
-                    if (endLine <= startLine) {
-                        endLine = startLine;
-                        continueLoop = false;
-                    }
+                _cursor = last + 1;
+                return true;
+            }
+        } else {
+            const auto range = std::upper_bound(_ranges.cbegin(), _ranges.cend(), _cursor, [](qint64 line, const QPair<qint64, qint64> &r) {
+                return line < r.first;
+            });
+            if (_cursor >= phase.to && _cursor >= dropped && range != _ranges.cbegin() && (range - 1)->second >= phase.to) {
+                last = qMin(_cursor, (range - 1)->second);
+                first = qMax(qMax((range - 1)->first, phase.to), last - SLICE_LINES + 1);
+                first = qMax(first, dropped);
+                while (first > dropped && isWrapped(first - 1)) {
+                    --first;
                 }
-            } else {
-                endLine += delta;
-
-                if (endLine > lastLine) {
-                    hasWrapped = true;
-                    endLine = lastLine;
-                } else if (endLine < 0) {
-                    hasWrapped = true;
-                    endLine = 0;
+                while (last < lastLine && isWrapped(last)) {
+                    ++last;
                 }
+                _cursor = first - 1;
+                return true;
             }
+        }
 
-            decoder.begin(&searchStream);
-            emulation->writeToStream(&decoder, qMin(endLine, line), qMax(endLine, line));
-            decoder.end();
+        if (++_phase < _phases.size()) {
+            _cursor = _phases.at(_phase).from;
+        }
+    }
+    return false;
+}
 
-            // line number search below assumes that the buffer ends with a new-line
-            string.append(QLatin1Char('\n'));
+void SearchHistoryTask::searchSlices()
+{
+    if (_cancelled) {
+        return;
+    }
+    if (!_session || !_window) {
+        finishSearch();
+        return;
+    }
 
-            const auto pos = forwards ? string.indexOf(_regExp) : string.lastIndexOf(_regExp);
+    // The lines were changed, start again
+    if (_window->screen() != _screen || _screen->historyResets() != _historyResets) {
+        startSearch();
+        return;
+    }
 
-            // if a match is found, position the cursor on that line and update the screen
-            if (pos != -1) {
-                int newLines = 0;
-                QList<int> linePositions = decoder.linePositions();
-                while (newLines < linePositions.count() && linePositions[newLines] <= pos) {
-                    newLines++;
-                }
+    qint64 first = 0;
+    qint64 last = 0;
+    if (_pendingSlices >= MAX_PENDING_SLICES) {
+        return;
+    }
+    if (!nextSlice(first, last)) {
+        if (_pendingSlices == 0) {
+            finishSearch();
+        }
+        return;
+    }
 
-                // ignore the new line at the start of the buffer
-                newLines--;
+    const qint64 dropped = _screen->totalDroppedLines();
+    const int lastLine = _screen->getHistLines() + _screen->getLines() - 1;
+
+    QString string;
+    QTextStream searchStream(&string);
+    PlainTextDecoder decoder;
+    decoder.setRecordLinePositions(true);
+    decoder.begin(&searchStream);
+    // Only the start of the last line is written when it is longer than the
+    // screen is wide, so write one more line
+    _screen->writeLinesToStream(&decoder, first - dropped, qMin<qint64>(last - dropped + 1, lastLine));
+    decoder.end();
+
+    ++_pendingSlices;
+    const int generation = _generation;
+    const int slice = _slicesStarted++;
+    const int phase = _phase;
+    const QList<int> linePositions = decoder.linePositions();
+    QThreadPool::globalInstance()->start(
+        [task = QPointer<SearchHistoryTask>(this), stopped = _stopped, regExp = _regExp, generation, slice, phase, string, linePositions, first, last]() {
+            const QList<qint64> lines = searchText(regExp, string, linePositions, first, last, *stopped);
+            if (*stopped) {
+                return;
+            }
+            // The task is only used in its thread, where it may have been deleted by now
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [task, generation, slice, phase, lines]() {
+                    if (task) {
+                        task->sliceSearched(generation, slice, phase, lines);
+                    }
+                },
+                Qt::QueuedConnection);
+        });
 
-                int findPos = qMin(line, endLine) + newLines;
+    // Build the search index for the next search while this one goes on
+    _screen->updateHistorySearchIndex(SLICE_LINES);
 
-                highlightResult(window, findPos);
+    _sliceTimer.start();
+}
 
-                Q_EMIT completed(true);
+void SearchHistoryTask::sliceSearched(int generation, int slice, int phase, const QList<qint64> &lines)
+{
+    if (_cancelled || generation != _generation) {
+        return;
+    }
+    --_pendingSlices;
 
-                return;
-            }
+    _sliceResults.insert(slice, {phase, lines});
+    while (!_sliceResults.isEmpty() && _sliceResults.firstKey() == _slicesProcessed) {
+        const auto [slicePhase, sliceLines] = _sliceResults.take(_slicesProcessed++);
+        processResults(slicePhase, sliceLines);
+    }
 
-            // if noWrap is checked and we wrapped, set cursor at last match
-            if (hasWrapped && _noWrap) {
-                // one chance to invert search direction
-                if (invertDirection) {
-                    continueLoop = false;
-                }
-                invertDirection = true;
-                forwards = !forwards;
-                delta = -delta;
-                endLine += (forwards ? 1 : -1);
-                hasWrapped = false;
+    if (_reportTimer.elapsed() >= REPORT_INTERVAL) {
+        reportResults();
+    }
+    if (!_sliceTimer.isActive()) {
+        _sliceTimer.start();
+    }
+}
+
+void SearchHistoryTask::processResults(int phase, const QList<qint64> &lines)
+{
+    for (const qint64 line : lines) {
+        _matches.insert(line);
+    }
+
+    // The results are processed in the order of the slices, so the first
+    // match in the direction of its phase is the result
+    if (!_found && !lines.isEmpty() && _window && _screen == _window->screen()) {
+        const Phase &p = _phases.at(phase);
+        const qint64 low = qMin(p.from, p.to);
+        const qint64 high = qMax(p.from, p.to);
+        qint64 findPos = -1;
+        for (const qint64 line : lines) {
+            if (line >= low && line <= high && (findPos == -1 || (p.ascending ? line < findPos : line > findPos))) {
+                findPos = line;
             }
+        }
 
-            // clear the current block of text and move to the next one
-            string.clear();
-            line = endLine;
-        } while (continueLoop);
-        if (!session->getSelectMode()) {
-            // if no match was found, clear selection to indicate this,
-            window->clearSelection();
-            window->notifyOutputChanged();
+        const qint64 screenLine = findPos - _screen->totalDroppedLines();
+        if (findPos != -1 && screenLine >= 0) {
+            _found = true;
+            highlightResult(_window, screenLine);
+            Q_EMIT completed(true);
+        }
+    }
+}
+
+void SearchHistoryTask::reportResults()
+{
+    _reportTimer.restart();
+    if (!_window) {
+        return;
+    }
+
+    const qint64 dropped = _screen->totalDroppedLines();
+    const int lineCount = _window->lineCount();
+    QSet<int> lines;
+    lines.reserve(_matches.size());
+    for (const qint64 line : std::as_const(_matches)) {
+        if (line >= dropped && line - dropped < lineCount) {
+            lines.insert(line - dropped);
+        }
+    }
+    Q_EMIT searchResults(lines, lineCount);
+}
 
-            Q_EMIT searchResults(QSet<int>{}, window->lineCount());
+void SearchHistoryTask::finishSearch()
+{
+    if (_session && _window) {
+        reportResults();
+
+        if (!_found && !_session->getSelectMode()) {
+            // if no match was found, clear selection to indicate this,
+            _window->clearSelection();
+            _window->notifyOutputChanged();
         }
     }
 
-    Q_EMIT completed(false);
+    if (!_found) {
+        Q_EMIT completed(false);
+    }
+
+    startNextWindow();
 }
+
 void SearchHistoryTask::highlightResult(const ScreenWindowPtr &window, int findPos)
 {
     // work out how many lines into the current block of text the search result was found
@@ -232,6 +445,15 @@ SearchHistoryTask::SearchHistoryTask(QObject *parent)
     , _noWrap(false)
     , _startLine(0)
 {
+    _sliceTimer.setSingleShot(true);
+    _sliceTimer.setInterval(0);
+    connect(&_sliceTimer, &QTimer::timeout, this, &SearchHistoryTask::searchSlices);
+}
+
+SearchHistoryTask::~SearchHistoryTask()
+{
+    // Don't wait for the searches running, their results are dropped
+    _stopped->store(true);
 }
 
 void SearchHistoryTask::setSearchDirection(Enum::SearchDirection direction)
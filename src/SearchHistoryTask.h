@@ -8,9 +8,15 @@
 #ifndef SEARCHHISTORYTASK_H
 #define SEARCHHISTORYTASK_H
 
+#include <QElapsedTimer>
 #include <QMap>
 #include <QPointer>
 #include <QRegularExpression>
+#include <QSet>
+#include <QTimer>
+
+#include <atomic>
+#include <memory>
 
 #include "Enumeration.h"
 #include "ScreenWindow.h"
@@ -20,7 +26,8 @@
 
 namespace Konsole
 {
-// class SearchHistoryThread;
+class Screen;
+
 /**
  * A task which searches through the output of sessions for matches for a given regular expression.
  * SearchHistoryTask operates on ScreenWindow instances rather than sessions added by addSession().
@@ -29,11 +36,16 @@ namespace Konsole
  * When execute() is called, the search begins in the direction specified by searchDirection(),
  * starting at the position of the current selection.
  *
+ * The output is decoded in slices on the GUI thread, between other events, and
+ * the regular expression is matched against them in the global thread pool.
+ * The lines where matches start are reported with searchResults() as they are
+ * found.
+ * When searching for a fixed string, the screen's history search index is used
+ * to only search the parts of the history which may contain it, once the index
+ * is built, which is done in slices while searching.
+ *
  * FIXME - This is not a proper implementation of SessionTask, in that it ignores sessions specified
  * with addSession()
- *
- * TODO - Implementation requirements:
- *          May provide progress feedback to the user when searching very large output logs.
  */
 class KONSOLEPRIVATE_EXPORT SearchHistoryTask : public SessionTask
 {
@@ -44,6 +56,7 @@ public:
      * Constructs a new search task.
      */
     explicit SearchHistoryTask(QObject *parent = nullptr);
+    ~SearchHistoryTask() override;
 
     /** Adds a screen window to the list to search when execute() is called. */
     void addScreenWindow(Session *session, ScreenWindow *searchWindow);
@@ -67,21 +80,43 @@ public:
     void setStartLine(int line);
 
     /**
-     * Performs a search through the session's history, starting at the position
+     * Starts a search through the session's history, starting at the position
      * of the current selection, in the direction specified by setSearchDirection().
      *
-     * If it finds a match, the ScreenWindow specified in the constructor is
-     * scrolled to the position where the match occurred and the selection
-     * is set to the matching text.  execute() then returns immediately.
+     * When the first match is found, the ScreenWindow specified in the constructor
+     * is scrolled to the position where the match occurred, the selection is set
+     * to the matching text and completed() is emitted.  The search goes on to find
+     * the other matches, which are reported by searchResults().
      *
      * To continue the search looking for further matches, call execute() again.
      */
     bool execute() override;
 
+    /**
+     * Stops the search without emitting completed(), and deletes the task if
+     * autoDelete() is set.
+     */
+    void cancel();
+
 private:
     using ScreenWindowPtr = QPointer<ScreenWindow>;
 
-    void executeOnScreenWindow(const QPointer<Session> &session, const ScreenWindowPtr &window);
+    // A part of the output which is searched in one direction
+    struct Phase {
+        qint64 from;
+        qint64 to;
+        bool ascending;
+    };
+
+    void startNextWindow();
+    void startSearch();
+    void finishSearch();
+    bool nextSlice(qint64 &first, qint64 &last);
+    bool isWrapped(qint64 line) const;
+    void searchSlices();
+    void sliceSearched(int generation, int slice, int phase, const QList<qint64> &lines);
+    void processResults(int phase, const QList<qint64> &lines);
+    void reportResults();
     void highlightResult(const ScreenWindowPtr &window, int findPos);
 
     QMap<QPointer<Session>, ScreenWindowPtr> _windows;
@@ -90,6 +125,33 @@ private:
     bool _noWrap;
     int _startLine;
 
+    // State of the search in the current window, lines are numbered from
+    // the start of the output, see Screen::totalDroppedLines()
+    QList<QPointer<Session>> _pendingSessions;
+    QPointer<Session> _session;
+    ScreenWindowPtr _window;
+    Screen *_screen = nullptr;
+    int _historyResets = 0;
+    QList<QPair<qint64, qint64>> _ranges;
+    QList<Phase> _phases;
+    int _phase = 0;
+    qint64 _cursor = 0;
+    int _pendingSlices = 0;
+    bool _found = false;
+    bool _cancelled = false;
+    QSet<qint64> _matches;
+    QElapsedTimer _reportTimer;
+    QTimer _sliceTimer;
+
+    // Slices are searched in parallel, their results are processed in the
+    // order of the slices.  Results of an earlier startSearch() are dropped.
+    int _generation = 0;
+    int _slicesStarted = 0;
+    int _slicesProcessed = 0;
+    QMap<int, QPair<int, QList<qint64>>> _sliceResults;
+    // Set when the task is cancelled or deleted, stops the searches running
+    std::shared_ptr<std::atomic<bool>> _stopped = std::make_shared<std::atomic<bool>>(false);
+
 Q_SIGNALS:
     void searchResults(const QSet<int>&, int);
 };
@@ -9,8 +9,14 @@
 #include "config-konsole.h"
 
 // Standard
+#include <bit>
+#include <climits>
 #include <cstdio>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 // Qt
 #include <QApplication>
 #include <QAudioOutput>
@@ -761,12 +767,52 @@ void Vt102Emulation::apc_end()
     }
 }
 
+// Returns the length of the run of printable ASCII characters (0x20 to 0x7E)
+// at the start of @p chars, which holds @p count characters.
+static int printableAsciiRunLength(const uint *chars, int count)
+{
+    int i = 0;
+#ifdef __SSE2__
+    // Check four characters at a time: c is printable iff (c - 0x20) < 0x5F
+    // unsigned. SSE2 only has signed compares, so flip the sign bits first.
+    const __m128i bias = _mm_set1_epi32(0x20);
+    const __m128i sign = _mm_set1_epi32(INT_MIN);
+    const __m128i limit = _mm_set1_epi32(0x5F ^ INT_MIN);
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(chars + i));
+        const __m128i inRange = _mm_cmplt_epi32(_mm_xor_si128(_mm_sub_epi32(v, bias), sign), limit);
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(inRange));
+        if (mask != 0xF) {
+            return i + std::countr_one(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    while (i < count && chars[i] >= 0x20 && chars[i] <= 0x7E) {
+        ++i;
+    }
+    return i;
+}
+
 void Vt102Emulation::receiveChars(const QVector<uint> &chars)
 {
-    for (uint cc : chars) {
+    const uint *data = chars.constData();
+    const int count = chars.size();
+
+    for (int i = 0; i < count; ++i) {
+        const uint cc = data[i];
+
         // early out for displayable characters
         if (_state == Ground && ((cc >= 0x20 && cc <= 0x7E) || cc >= 0xA0)) {
-            _currentScreen->displayCharacter(applyCharset(cc));
+            const CharCodes &charset = _charset[_currentScreen == _screen[1]];
+            if (cc <= 0x7E && !charset.graphic && !charset.pound) {
+                // Plain ASCII is not affected by the charset, so hand the
+                // whole run to the screen at once
+                const int runLength = printableAsciiRunLength(data + i, count - i);
+                _currentScreen->displayRun(data + i, runLength);
+                i += runLength - 1;
+            } else {
+                _currentScreen->displayCharacter(applyCharset(cc));
+            }
             continue;
         }
 
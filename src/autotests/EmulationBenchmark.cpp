@@ -0,0 +1,453 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Own
+#include "EmulationBenchmark.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTest>
+
+// Konsole
+#include "../Emulation.h"
+#include "../history/HistoryTypeFile.h"
+#include "../history/HistoryTypeNone.h"
+#include "../history/compact/CompactHistoryType.h"
+#include "../session/Session.h"
+#include "../session/SessionController.h"
+#include "../session/SessionManager.h"
+#include "../terminalDisplay/TerminalDisplay.h"
+
+// STD
+#include <atomic>
+#include <cerrno>
+#include <memory>
+
+using namespace Konsole;
+
+// On glibc, all the allocation functions of the C library, which operator new
+// and the Qt containers use, are replaced by ones which count the calls, see
+// "Replacing malloc" in the glibc manual. Sanitizers replace them too, so
+// allocations aren't counted with those
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer)
+#define KONSOLE_SANITIZED_BUILD
+#endif
+#endif
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(KONSOLE_SANITIZED_BUILD)
+#define KONSOLE_COUNT_ALLOCATIONS
+#endif
+
+// Number of allocations made by the process
+static std::atomic<quint64> allocationCount{0};
+
+#ifdef KONSOLE_COUNT_ALLOCATIONS
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void *__libc_valloc(size_t size);
+void *__libc_pvalloc(size_t size);
+void __libc_free(void *ptr);
+
+static void countAllocation()
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void *malloc(size_t size) noexcept
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+
+void *reallocarray(void *ptr, size_t count, size_t size) noexcept
+{
+    size_t total;
+    if (__builtin_mul_overflow(count, size, &total)) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    countAllocation();
+    return __libc_realloc(ptr, total);
+}
+
+// operator new with an alignment uses aligned_alloc()
+void *memalign(size_t alignment, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) noexcept
+{
+    if (alignment == 0 || alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    countAllocation();
+    void *result = __libc_memalign(alignment, size);
+    if (result == nullptr) {
+        return ENOMEM;
+    }
+    *ptr = result;
+    return 0;
+}
+
+void *valloc(size_t size) noexcept
+{
+    countAllocation();
+    return __libc_valloc(size);
+}
+
+void *pvalloc(size_t size) noexcept
+{
+    countAllocation();
+    return __libc_pvalloc(size);
+}
+
+void free(void *ptr) noexcept
+{
+    __libc_free(ptr);
+}
+}
+#endif
+
+// Resets the peak resident set size of the process, where supported
+static void resetPeakResidentSize()
+{
+#ifdef Q_OS_LINUX
+    QFile clearRefs(QStringLiteral("/proc/self/clear_refs"));
+    if (clearRefs.open(QIODevice::WriteOnly)) {
+        clearRefs.write("5");
+    }
+#endif
+}
+
+// Returns the peak resident set size of the process in KiB, or -1
+static qint64 peakResidentSize()
+{
+#ifdef Q_OS_LINUX
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (status.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> lines = status.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+            }
+        }
+    }
+#endif
+    return -1;
+}
+
+static const int CORPUS_SIZE = 1024 * 1024;
+static const int LINES = 40;
+static const int COLUMNS = 120;
+
+// Size of the reads from the pty
+static const int CHUNK_SIZE = 4096;
+// Number of chunks received between two updates of the views
+static const int FRAME_CHUNKS = 16;
+
+// Log lines of varying length, some of them wrapped
+static QByteArray asciiCorpus()
+{
+    static const char *const levels[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+
+    QRandomGenerator random(1);
+    QByteArray data;
+    for (int line = 0; data.size() < CORPUS_SIZE; line++) {
+        data += QString::asprintf("2026-01-01 12:%02d:%02d.%03d %-7s [worker-%d] GET /api/v1/items/%u?page=%d&size=%d processed in %d ms",
+                                  line / 3600 % 60,
+                                  line / 60 % 60,
+                                  line % 1000,
+                                  levels[random.bounded(4)],
+                                  random.bounded(16),
+                                  random.generate(),
+                                  random.bounded(1000),
+                                  random.bounded(100),
+                                  random.bounded(5000))
+                    .toLatin1();
+        data += QByteArray(random.bounded(COLUMNS), '.');
+        data += "\r\n";
+    }
+    return data;
+}
+
+// Compiler diagnostics with 256 colours and true colour gradients
+static QByteArray sgrCorpus()
+{
+    QRandomGenerator random(2);
+    QByteArray data;
+    for (int line = 0; data.size() < CORPUS_SIZE; line++) {
+        if (line % 8 == 7) {
+            for (int column = 0; column < COLUMNS; column++) {
+                const int red = column * 255 / COLUMNS;
+                data += QString::asprintf("\033[48;2;%d;%d;%dm\033[38;2;%d;%d;%dm%c", red, line % 256, 255 - red, 255 - red, 128, red, 'a' + column % 26)
+                            .toLatin1();
+            }
+            data += "\033[0m\r\n";
+        } else {
+            data += QString::asprintf("\033[1msrc/module%d.cpp:%d:%d: \033[1;31merror: \033[0m\033[1muse of undeclared identifier '\033[38;5;%dm%s%d\033[39m'\033[0m\r\n",
+                                      random.bounded(100),
+                                      random.bounded(5000),
+                                      random.bounded(120),
+                                      random.bounded(256),
+                                      "variable",
+                                      random.bounded(1000))
+                        .toLatin1();
+        }
+    }
+    return data;
+}
+
+// CJK, Hangul and emoji, with combining characters and ZWJ sequences
+static QByteArray unicodeCorpus()
+{
+    QRandomGenerator random(3);
+    QByteArray data;
+    while (data.size() < CORPUS_SIZE) {
+        QString line;
+        for (int column = 0; column < COLUMNS / 2; column++) {
+            switch (random.bounded(6)) {
+            case 0:
+            case 1:
+                line += QChar(0x4E00 + random.bounded(0x5200));
+                break;
+            case 2:
+                line += QChar(0xAC00 + random.bounded(0x2BA4));
+                break;
+            case 3: {
+                const char32_t emoji = 0x1F600 + random.bounded(0x50);
+                line += QString::fromUcs4(&emoji, 1);
+                break;
+            }
+            case 4:
+                line += QStringLiteral("e\u0301");
+                break;
+            default:
+                line += QStringLiteral("\U0001F468\u200D\U0001F469\u200D\U0001F467");
+                break;
+            }
+        }
+        data += line.toUtf8() + "\r\n";
+    }
+    return data;
+}
+
+// Full screen redraws on the alternate screen, like htop, and scrolling in a
+// region, like vim
+static QByteArray redrawCorpus()
+{
+    QRandomGenerator random(4);
+    QByteArray data = "\033[?1049h\033[?25l";
+    for (int frame = 0; data.size() < CORPUS_SIZE; frame++) {
+        if (frame % 2 == 0) {
+            data += "\033[H";
+            for (int line = 1; line <= LINES; line++) {
+                const int bar = random.bounded(COLUMNS / 2);
+                data += QString::asprintf("\033[%d;1H\033[1m%3d\033[0m [\033[32m%s\033[31m%s\033[0m%*s] %5d %s\033[K",
+                                          line,
+                                          line,
+                                          QByteArray(bar / 2, '|').constData(),
+                                          QByteArray(bar - bar / 2, '|').constData(),
+                                          COLUMNS / 2 - bar,
+                                          "",
+                                          random.bounded(100000),
+                                          "/usr/bin/process --option")
+                            .toLatin1();
+            }
+        } else {
+            data += QString::asprintf("\033[1;%dr\033[%d;1H\n\033[33m%4d\033[0m    if (value != nullptr) { return value->next(%d); }\033[K\033[r",
+                                      LINES - 2,
+                                      LINES - 2,
+                                      frame,
+                                      random.bounded(1000))
+                        .toLatin1();
+            data += QString::asprintf("\033[%d;1H\033[7m-- INSERT -- %d,%d\033[0m\033[K", LINES, frame, random.bounded(COLUMNS)).toLatin1();
+        }
+    }
+    data += "\033[?1049l\033[?25h";
+    return data;
+}
+
+// Sixel images of 64x48 pixels, between lines of text
+static QByteArray sixelCorpus()
+{
+    QRandomGenerator random(5);
+    QByteArray data;
+    while (data.size() < CORPUS_SIZE) {
+        data += "\033Pq\"1;1;64;48";
+        for (int color = 0; color < 4; color++) {
+            data += QString::asprintf("#%d;2;%d;%d;%d", color, random.bounded(101), random.bounded(101), random.bounded(101)).toLatin1();
+        }
+        for (int band = 0; band < 8; band++) {
+            for (int color = 0; color < 4; color++) {
+                data += QString::asprintf("#%d!%d%c!%d%c$", color, random.bounded(32) + 1, char('?' + random.bounded(64)), random.bounded(32) + 1, char('?' + random.bounded(64)))
+                            .toLatin1();
+            }
+            data += '-';
+        }
+        data += "\033\\\r\nimage caption\r\n";
+    }
+    return data;
+}
+
+// Kitty graphics protocol images of 32x16 RGB pixels, between lines of text
+static QByteArray kittyCorpus()
+{
+    QRandomGenerator random(6);
+    QByteArray data;
+    while (data.size() < CORPUS_SIZE) {
+        QByteArray pixels(32 * 16 * 3, Qt::Uninitialized);
+        for (char &pixel : pixels) {
+            pixel = char(random.bounded(256));
+        }
+        data += "\033_Ga=T,f=24,s=32,v=16;" + pixels.toBase64() + "\033\\\r\nimage caption\r\n";
+    }
+    return data;
+}
+
+void EmulationBenchmark::initTestCase()
+{
+    _corpora = {
+        {QStringLiteral("ascii"), asciiCorpus()},
+        {QStringLiteral("sgr"), sgrCorpus()},
+        {QStringLiteral("unicode"), unicodeCorpus()},
+        {QStringLiteral("redraw"), redrawCorpus()},
+        {QStringLiteral("sixel"), sixelCorpus()},
+        {QStringLiteral("kitty"), kittyCorpus()},
+    };
+
+    const QString corporaPath = qEnvironmentVariable("KONSOLE_BENCHMARK_CORPORA");
+    if (!corporaPath.isEmpty()) {
+        const QFileInfoList files = QDir(corporaPath).entryInfoList(QDir::Files, QDir::Name);
+        for (const QFileInfo &fileInfo : files) {
+            QFile file(fileInfo.filePath());
+            if (file.open(QIODevice::ReadOnly)) {
+                _corpora.append({fileInfo.fileName(), file.readAll()});
+            }
+        }
+    }
+}
+
+void EmulationBenchmark::benchmarkReceiveData_data()
+{
+    QTest::addColumn<QByteArray>("corpus");
+    QTest::addColumn<QString>("history");
+    QTest::addColumn<bool>("display");
+
+    const QStringList histories = {QStringLiteral("none"), QStringLiteral("compact"), QStringLiteral("file")};
+    for (const auto &[name, corpus] : std::as_const(_corpora)) {
+        for (const QString &history : histories) {
+            QTest::addRow("%s/%s", qPrintable(name), qPrintable(history)) << corpus << history << false;
+            QTest::addRow("%s/%s/display", qPrintable(name), qPrintable(history)) << corpus << history << true;
+        }
+    }
+}
+
+void EmulationBenchmark::benchmarkReceiveData()
+{
+    QFETCH(QByteArray, corpus);
+    QFETCH(QString, history);
+    QFETCH(bool, display);
+
+    Session *session = SessionManager::instance()->createSession();
+    Emulation *emulation = session->emulation();
+    if (history == QLatin1String("none")) {
+        emulation->setHistory(HistoryTypeNone());
+    } else if (history == QLatin1String("compact")) {
+        emulation->setHistory(CompactHistoryType(10000));
+    } else {
+        emulation->setHistory(HistoryTypeFile());
+    }
+
+    std::unique_ptr<TerminalDisplay> view;
+    std::unique_ptr<SessionController> controller;
+    if (display) {
+        view = std::make_unique<TerminalDisplay>(nullptr);
+        controller = std::make_unique<SessionController>(session, view.get(), nullptr);
+        session->addView(view.get());
+        view->setSize(COLUMNS, LINES);
+        view->resize(view->sizeHint());
+        view->show();
+        if (!QTest::qWaitForWindowExposed(view.get())) {
+            controller.reset();
+            view.reset();
+            SessionManager::instance()->sessionTerminated(session);
+            QSKIP("Cannot show the terminal display");
+        }
+    } else {
+        emulation->setImageSize(LINES, COLUMNS);
+    }
+
+    resetPeakResidentSize();
+    const quint64 allocationsBefore = allocationCount.load();
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK {
+        for (int position = 0; position < corpus.size(); position += CHUNK_SIZE) {
+            emulation->receiveData(corpus.constData() + position, qMin(CHUNK_SIZE, int(corpus.size()) - position));
+
+            // Update the views as the frame timer of the emulation would
+            if ((position / CHUNK_SIZE) % FRAME_CHUNKS == FRAME_CHUNKS - 1 || position + CHUNK_SIZE >= corpus.size()) {
+                QMetaObject::invokeMethod(emulation, "showBulk");
+                if (view) {
+                    view->repaint();
+                }
+            }
+        }
+        iterations++;
+    }
+
+    const qint64 elapsed = timer.nsecsElapsed();
+    const double megabytes = double(corpus.size()) * iterations / 1000000;
+    const quint64 allocationsAfter = allocationCount.load();
+    const qint64 peakSize = peakResidentSize();
+#ifdef KONSOLE_COUNT_ALLOCATIONS
+    const QString allocations = QString::number((allocationsAfter - allocationsBefore) / megabytes, 'f', 0);
+#else
+    Q_UNUSED(allocationsAfter)
+    const QString allocations = QStringLiteral("unknown");
+#endif
+    qInfo("%s: %.1f MB/s, %s allocations/MB, peak RSS %s",
+          QTest::currentDataTag(),
+          megabytes * 1000000000 / qMax<qint64>(elapsed, 1),
+          qPrintable(allocations),
+          peakSize >= 0 ? qPrintable(QStringLiteral("%1 KiB").arg(peakSize)) : "unknown");
+
+    controller.reset();
+    view.reset();
+    SessionManager::instance()->sessionTerminated(session);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+QTEST_MAIN(EmulationBenchmark)
+
+#include "moc_EmulationBenchmark.cpp"
@@ -0,0 +1,47 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef EMULATIONBENCHMARK_H
+#define EMULATIONBENCHMARK_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QString>
+
+namespace Konsole
+{
+/**
+ * Measures the throughput of the emulation pipeline: output is fed through
+ * Emulation::receiveData() in pty sized chunks, with the views updated once
+ * per frame.
+ *
+ * Besides a set of generated corpora, the files in the directory named by the
+ * KONSOLE_BENCHMARK_CORPORA environment variable are used as recorded output,
+ * for example typescripts recorded with script(1).
+ *
+ * Each row reports the throughput in MB/s, the allocations per MB, which are
+ * only counted on glibc, and the peak resident set size.
+ *
+ * It is built with the BUILD_BENCHMARKS option.
+ */
+class EmulationBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkReceiveData_data();
+    void benchmarkReceiveData();
+
+private:
+    QList<QPair<QString, QByteArray>> _corpora;
+};
+
+}
+
+#endif // EMULATIONBENCHMARK_H
@@ -7,6 +7,7 @@
 // Own
 #include "HistoryTest.h"
 
+#include <QRandomGenerator>
 #include <QTest>
 
 // Konsole
@@ -218,6 +219,245 @@ void HistoryTest::testHistoryTypeChange()
     QCOMPARE(historyScroll->getLines(), 0);
 }
 
+// Returns a line of test cells, which mixes 1, 2 and 4 byte code points and
+// changes attributes in runs.  With @p longLines every tenth line is longer
+// than an encoded chunk.
+static QVector<Character> makeLine(int lineNumber, bool longLines)
+{
+    QVector<Character> line(longLines && lineNumber % 10 == 0 ? 5000 : (lineNumber * 37) % 150);
+    for (int i = 0; i < line.size(); ++i) {
+        const int n = lineNumber + i;
+        const uint c = (n % 97 == 0) ? 0x1F600 + n % 50 : (n % 13 == 0) ? 0x4E00 + n % 500 : 'a' + n % 26;
+        line[i] = Character(c,
+                            CharacterColor(COLOR_SPACE_256, (i / 10) % 256),
+                            CharacterColor(COLOR_SPACE_DEFAULT, DEFAULT_BACK_COLOR),
+                            (i / 20) % 2 ? RE_BOLD : DEFAULT_RENDITION);
+    }
+    return line;
+}
+
+void HistoryTest::testCompactHistoryStorage()
+{
+    // Enough lines to fill many blocks, so some are stored compressed
+    const int maxLines = 3000;
+    const int addedLines = 5000;
+    CompactHistoryScroll history(maxLines);
+
+    for (int i = 0; i < addedLines; ++i) {
+        const QVector<Character> line = makeLine(i, false);
+        history.addCells(line.constData(), line.size());
+        history.addLine(LineProperty(i % 2 ? LINE_WRAPPED : 0));
+    }
+    QCOMPARE(history.getLines(), maxLines);
+
+    auto verifyLine = [&history](int lineNumber, int addedLine) {
+        const QVector<Character> expected = makeLine(addedLine, false);
+        QCOMPARE(history.getLineLen(lineNumber), int(expected.size()));
+        QCOMPARE(history.isWrappedLine(lineNumber), addedLine % 2 == 1);
+        QVector<Character> cells(expected.size());
+        history.getCells(lineNumber, 0, cells.size(), cells.data());
+        for (int i = 0; i < cells.size(); ++i) {
+            QCOMPARE(cells[i], expected[i]);
+            QCOMPARE(cells[i].flags, expected[i].flags);
+        }
+    };
+
+    // Read backwards, as when scrolling up through the history
+    for (int line = maxLines - 1; line >= 0; --line) {
+        verifyLine(line, addedLines - maxLines + line);
+    }
+
+    // Partial reads in the middle of a line
+    const QVector<Character> expected = makeLine(addedLines - maxLines + 1, false);
+    Character cells[5];
+    history.getCells(1, 3, 5, cells);
+    for (int i = 0; i < 5; ++i) {
+        QCOMPARE(cells[i], expected[3 + i]);
+    }
+
+    // Removing lines from the end and adding them again
+    for (int i = 0; i < 100; ++i) {
+        history.removeCells();
+    }
+    QCOMPARE(history.getLines(), maxLines - 100);
+    for (int i = addedLines - 100; i < addedLines; ++i) {
+        const QVector<Character> line = makeLine(i, false);
+        history.addCells(line.constData(), line.size());
+        history.addLine(LineProperty(i % 2 ? LINE_WRAPPED : 0));
+    }
+    for (int line = 0; line < maxLines; ++line) {
+        verifyLine(line, addedLines - maxLines + line);
+    }
+}
+
+void HistoryTest::testHistoryFileStorage()
+{
+    HistoryScrollFile history;
+
+    const int addedLines = 3000;
+    QVector<Character> all;
+    for (int i = 0; i < addedLines; ++i) {
+        const QVector<Character> line = makeLine(i, true);
+        history.addCells(line.constData(), line.size());
+        history.addLine(LineProperty(LINE_WRAPPED));
+        all += line;
+    }
+    QCOMPARE(history.getLines(), addedLines);
+
+    for (int line = addedLines - 1; line >= 0; --line) {
+        const QVector<Character> expected = makeLine(line, true);
+        QCOMPARE(history.getLineLen(line), int(expected.size()));
+        QVector<Character> cells(expected.size());
+        history.getCells(line, 0, cells.size(), cells.data());
+        QCOMPARE(cells, expected);
+    }
+
+    // All lines but the last are wrapped, so reflowing joins them into one
+    // line and splits it at the new width, which is not a multiple of the
+    // chunk size.  Removing lines first drops the end of a chunk.
+    for (int i = 0; i < 5; ++i) {
+        history.removeCells();
+    }
+    history.setLineProperty(history.getLines() - 1, LineProperty());
+    const int columns = 77;
+    QCOMPARE(history.reflowLines(columns), 0);
+
+    int cell = 0;
+    for (int line = 0; line < history.getLines(); ++line) {
+        const int length = history.getLineLen(line);
+        QVERIFY(length <= columns);
+        QVector<Character> cells(length);
+        history.getCells(line, 0, length, cells.data());
+        QCOMPARE(cells, all.mid(cell, length));
+        cell += length;
+    }
+    for (int i = addedLines - 5; i < addedLines; ++i) {
+        cell += makeLine(i, true).size();
+    }
+    QCOMPARE(cell, int(all.size()));
+
+    // Most reflowed lines start in the middle of a chunk, so removing them
+    // encodes the end of the previous line again, which must be kept
+    const int keptLines = history.getLines() - 20;
+    int keptCells = 0;
+    for (int line = 0; line < keptLines; ++line) {
+        keptCells += history.getLineLen(line);
+    }
+    while (history.getLines() > keptLines) {
+        history.removeCells();
+    }
+    const QVector<Character> addedLine = makeLine(1, false);
+    history.addCells(addedLine.constData(), addedLine.size());
+    history.addLine(LineProperty());
+
+    const QVector<Character> expected = all.mid(0, keptCells) + addedLine;
+    cell = 0;
+    for (int line = 0; line < history.getLines(); ++line) {
+        const int length = history.getLineLen(line);
+        QVector<Character> cells(length);
+        history.getCells(line, 0, length, cells.data());
+        QCOMPARE(cells, expected.mid(cell, length));
+        cell += length;
+    }
+    QCOMPARE(cell, int(expected.size()));
+}
+
+void HistoryTest::testHistorySearchIndex()
+{
+    HistorySearchIndex index;
+    QVERIFY(!index.isValid());
+    index.clear();
+    QVERIFY(index.isValid());
+
+    auto addLine = [&index](const QString &text, bool wrapped) {
+        QVector<Character> line;
+        const QList<uint> codePoints = text.toUcs4();
+        for (const uint c : codePoints) {
+            line.append(Character(c));
+        }
+        index.addLine(line.constData(), line.size(), LineProperty(wrapped ? LINE_WRAPPED : 0));
+    };
+
+    // "needle" appears on line 500, and split between the wrapped lines
+    // 700 and 701, with a different case
+    for (int i = 0; i < 1000; ++i) {
+        if (i == 500) {
+            addLine(QStringLiteral("a needle here"), false);
+        } else if (i == 700) {
+            addLine(QStringLiteral("xx NEE"), true);
+        } else if (i == 701) {
+            addLine(QStringLiteral("dle yy"), false);
+        } else {
+            addLine(QStringLiteral("line %1").arg(i), false);
+        }
+    }
+    QCOMPARE(index.lineCount(), 1000);
+    QCOMPARE(index.openLineStart(), 1000);
+
+    auto candidates = [&index](const QString &text, int line, int maximum) {
+        int count = 0;
+        bool found = false;
+        const QList<QPair<int, int>> ranges = index.candidateLines(text);
+        for (const auto &[first, last] : ranges) {
+            count += last - first + 1;
+            found = found || (first <= line && line <= last);
+        }
+        return found && count <= maximum;
+    };
+
+    const int block = HistorySearchIndex::BlockLines;
+    QVERIFY(candidates(QStringLiteral("needle"), 500, 2 * block));
+    QVERIFY(candidates(QStringLiteral("needle"), 700, 2 * block));
+    QVERIFY(candidates(QStringLiteral("Needle"), 701, 2 * block));
+    // Too short to use the index
+    QVERIFY(candidates(QStringLiteral("ne"), 0, 1000));
+
+    index.removeFirstLines(600);
+    QCOMPARE(index.lineCount(), 400);
+    QVERIFY(candidates(QStringLiteral("needle"), 100, 2 * block));
+
+    addLine(QStringLiteral("more"), true);
+    addLine(QStringLiteral("text"), true);
+    QCOMPARE(index.openLineStart(), 400);
+    QVERIFY(candidates(QStringLiteral("moretext"), 401, 2 * block));
+
+    index.invalidate();
+    QVERIFY(!index.isValid());
+}
+
+void HistoryTest::testHistorySearchIndexWideLines()
+{
+    HistorySearchIndex index;
+    index.clear();
+
+    // Lines full of different text, whose trigrams would set most bits of
+    // the signature of a block of BlockLines lines
+    QRandomGenerator random(42);
+    for (int i = 0; i < 1000; ++i) {
+        QVector<Character> line;
+        for (int column = 0; column < 200; ++column) {
+            line.append(Character(char32_t('a' + random.bounded(26))));
+        }
+        if (i == 500) {
+            const QString needle = QStringLiteral("0needle0");
+            for (int column = 0; column < needle.size(); ++column) {
+                line[100 + column] = Character(needle.at(column).unicode());
+            }
+        }
+        index.addLine(line.constData(), line.size(), LineProperty());
+    }
+
+    int candidates = 0;
+    bool found = false;
+    const QList<QPair<int, int>> ranges = index.candidateLines(QStringLiteral("0needle0"));
+    for (const auto &[first, last] : ranges) {
+        candidates += last - first + 1;
+        found = found || (first <= 500 && 500 <= last);
+    }
+    QVERIFY(found);
+    QVERIFY(candidates < HistorySearchIndex::BlockLines);
+}
+
 QTEST_MAIN(HistoryTest)
 
 #include "moc_HistoryTest.cpp"
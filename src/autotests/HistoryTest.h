@@ -10,6 +10,7 @@
 #include "../characters/Character.h"
 #include "../history/HistoryScrollFile.h"
 #include "../history/HistoryScrollNone.h"
+#include "../history/HistorySearchIndex.h"
 #include "../history/HistoryTypeFile.h"
 #include "../history/HistoryTypeNone.h"
 #include "../history/compact/CompactHistoryScroll.h"
@@ -31,6 +32,10 @@ private Q_SLOTS:
     void testHistoryScroll();
     void testHistoryReflow();
     void testHistoryTypeChange();
+    void testCompactHistoryStorage();
+    void testHistoryFileStorage();
+    void testHistorySearchIndex();
+    void testHistorySearchIndexWideLines();
 
 private:
     static constexpr const char testString[] = "abcdefghijklmnopqrstuvwxyz1234567890";
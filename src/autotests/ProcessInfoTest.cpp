@@ -13,6 +13,7 @@
 #include <QTest>
 
 // Konsole
+#include "../ProcFile.h"
 #include "../ProcessInfo.h"
 #include "../session/Session.h"
 
@@ -112,6 +113,33 @@ void ProcessInfoTest::testProcessNameSpecialChars()
 #endif
 }
 
+void ProcessInfoTest::testParseStat()
+{
+    // The name may contain spaces and parentheses
+    const auto stat = ProcFile::parseStat("4242 (a) b (c) S 1234 4242 4242 34817 5678 4194560 1107 0 0 0\n");
+    QVERIFY(stat.has_value());
+    QCOMPARE(stat->name.toByteArray(), QByteArray("a) b (c"));
+    QCOMPARE(stat->parentPid, 1234);
+    QCOMPARE(stat->foregroundPid, 5678);
+
+    QVERIFY(!ProcFile::parseStat("").has_value());
+    QVERIFY(!ProcFile::parseStat("4242 (bash) S 1234").has_value());
+}
+
+void ProcessInfoTest::testParseStatusUid()
+{
+    const auto uid = ProcFile::parseStatusUid(
+        "Name:\tbash\n"
+        "Umask:\t0022\n"
+        "State:\tS (sleeping)\n"
+        "Uid:\t1000\t0\t0\t0\n"
+        "Gid:\t1000\t1000\t1000\t1000\n");
+    QVERIFY(uid.has_value());
+    QCOMPARE(*uid, 1000);
+
+    QVERIFY(!ProcFile::parseStatusUid("Name:\tbash\n").has_value());
+}
+
 QTEST_MAIN(ProcessInfoTest)
 
 #include "moc_ProcessInfoTest.cpp"
@@ -26,6 +26,8 @@ private Q_SLOTS:
     void testProcessValidity();
     void testProcessCwd();
     void testProcessNameSpecialChars();
+    void testParseStat();
+    void testParseStatusUid();
 
 private:
     std::unique_ptr<ProcessInfo> createProcInfo(const KProcess &proc);
@@ -12,6 +12,13 @@
 #include <QStringList>
 #include <QTest>
 
+// System
+#include <cstring>
+#include <unistd.h>
+
+// Konsole
+#include "../PtyReader.h"
+
 using namespace Konsole;
 
 void PtyTest::init()
@@ -81,6 +88,71 @@ void PtyTest::testRunProgram()
     pty.close();
 }
 
+void PtyTest::testRingBuffer()
+{
+    PtyRingBuffer buffer(8);
+    QCOMPARE(buffer.writeSpan().size(), size_t(8));
+    QCOMPARE(buffer.readView(), QByteArrayView());
+
+    memcpy(buffer.writeSpan().data(), "abcdef", 6);
+    buffer.commitWrite(6);
+    QCOMPARE(buffer.size(), 6);
+    QCOMPARE(buffer.readView(), QByteArrayView("abcdef"));
+    buffer.commitRead(4);
+
+    // The free space wraps around the end of the buffer
+    QCOMPARE(buffer.writeSpan().size(), size_t(2));
+    memcpy(buffer.writeSpan().data(), "gh", 2);
+    buffer.commitWrite(2);
+    QCOMPARE(buffer.writeSpan().size(), size_t(4));
+    memcpy(buffer.writeSpan().data(), "ijkl", 4);
+    buffer.commitWrite(4);
+    QCOMPARE(buffer.writeSpan().size(), size_t(0));
+    QCOMPARE(buffer.size(), 8);
+
+    // So do the used bytes
+    QCOMPARE(buffer.readView(), QByteArrayView("efgh"));
+    buffer.commitRead(4);
+    QCOMPARE(buffer.readView(), QByteArrayView("ijkl"));
+    buffer.commitRead(4);
+    QCOMPARE(buffer.size(), 0);
+}
+
+void PtyTest::testReaderThread()
+{
+    int fds[2];
+    QCOMPARE(pipe(fds), 0);
+
+    QByteArray expected;
+    for (int i = 0; expected.size() < 4 * PtyReader::maxSliceSize(); i++) {
+        expected += QByteArray::number(i) + '\n';
+    }
+
+    QByteArray received;
+    int largestSlice = 0;
+    {
+        PtyReader reader(fds[0]);
+        QVERIFY(reader.isValid());
+        connect(&reader, &PtyReader::receivedData, this, [&](const char *buffer, int length) {
+            received.append(buffer, length);
+            largestSlice = qMax(largestSlice, length);
+        });
+
+        // More than the pipe holds, the reader thread drains it while the event loop does not run
+        for (qsizetype written = 0; written < expected.size();) {
+            const ssize_t length = write(fds[1], expected.constData() + written, expected.size() - written);
+            QVERIFY(length > 0);
+            written += length;
+        }
+        close(fds[1]);
+
+        QTRY_COMPARE(received.size(), expected.size());
+        QCOMPARE(received, expected);
+        QVERIFY(largestSlice <= PtyReader::maxSliceSize());
+    }
+    close(fds[0]);
+}
+
 QTEST_GUILESS_MAIN(PtyTest)
 
 #include "moc_PtyTest.cpp"
@@ -25,6 +25,9 @@ private Q_SLOTS:
     void testWindowSize();
 
     void testRunProgram();
+
+    void testRingBuffer();
+    void testReaderThread();
 };
 
 }
@@ -6,6 +6,7 @@
 
 // Own
 #include "ScreenTest.h"
+#include "../history/compact/CompactHistoryType.h"
 
 // Qt
 #include <QString>
@@ -240,6 +241,169 @@ void ScreenTest::testCursorPosition()
     delete screen;
 }
 
+// displayRun() must leave the screen exactly as displayCharacter() would,
+// including when the run wraps over several lines and scrolls into history.
+void ScreenTest::testDisplayRun()
+{
+    const int lines = 4;
+    const int columns = 10;
+    Screen perCharacter(lines, columns);
+    Screen run(lines, columns);
+
+    QVector<uint> text;
+    for (int i = 0; i < 47; ++i) {
+        text.append(0x20 + (i * 7) % 0x5F);
+    }
+
+    perCharacter.cursorRight(3);
+    run.cursorRight(3);
+    for (uint c : std::as_const(text)) {
+        perCharacter.displayCharacter(c);
+    }
+    run.displayRun(text.constData(), text.size());
+
+    doComparePosition(&run, perCharacter.getCursorY(), perCharacter.getCursorX());
+    QCOMPARE(run.getHistLines(), perCharacter.getHistLines());
+
+    QVector<Character> expected(lines * columns);
+    QVector<Character> actual(lines * columns);
+    perCharacter.getImage(expected.data(), expected.size(), 0, lines - 1);
+    run.getImage(actual.data(), actual.size(), 0, lines - 1);
+    QVERIFY(actual == expected);
+
+    const QVector<LineProperty> expectedProperties = perCharacter.getLineProperties(0, lines - 1);
+    const QVector<LineProperty> actualProperties = run.getLineProperties(0, lines - 1);
+    for (int i = 0; i < lines; ++i) {
+        QCOMPARE(actualProperties[i].flags.all, expectedProperties[i].flags.all);
+        QCOMPARE(actualProperties[i].length, expectedProperties[i].length);
+    }
+}
+
+void ScreenTest::testTotalDroppedLines()
+{
+    const int lines = 3;
+    Screen screen(lines, 10);
+    screen.setCursorYX(lines, 1);
+
+    // Without history, the lines scrolled off the screen are dropped
+    for (int i = 0; i < 4; ++i) {
+        screen.index();
+    }
+    QCOMPARE(screen.totalDroppedLines(), qint64(4));
+
+    const int resets = screen.historyResets();
+    screen.setScroll(CompactHistoryType(5));
+    QVERIFY(screen.historyResets() != resets);
+
+    // The history keeps the first 5 lines, then drops one line per line added
+    for (int i = 0; i < 8; ++i) {
+        screen.index();
+    }
+    QCOMPARE(screen.getHistLines(), 5);
+    QCOMPARE(screen.totalDroppedLines(), qint64(4 + 3));
+}
+
+void ScreenTest::testLineGenerations()
+{
+    const int lines = 4;
+    Screen screen(lines, 10);
+    screen.setCursorYX(lines, 1);
+
+    const quint64 first = screen.lineGeneration(0);
+    const quint64 second = screen.lineGeneration(1);
+    QVERIFY(first != 0);
+    QVERIFY(second != 0 && second != first);
+    QCOMPARE(screen.lineGeneration(0), first);
+    // The image of the cursor line is not tracked
+    QCOMPARE(screen.lineGeneration(lines - 1), quint64(0));
+
+    // Writing to a line changes its generation
+    screen.setCursorYX(1, 1);
+    screen.displayCharacter('a');
+    screen.setCursorYX(lines, 1);
+    QVERIFY(screen.lineGeneration(0) != first);
+    QCOMPARE(screen.lineGeneration(1), second);
+
+    // Scrolled lines keep their generation
+    screen.index();
+    QCOMPARE(screen.lineGeneration(0), second);
+
+    // Neither is the image of the lines while there is a selection
+    screen.setSelectionStart(0, 0, false);
+    screen.setSelectionEnd(2, 0, false);
+    QCOMPARE(screen.lineGeneration(0), quint64(0));
+    screen.clearSelection();
+    QCOMPARE(screen.lineGeneration(0), second);
+}
+
+void ScreenTest::testHistorySearchIndexSlices()
+{
+    const int lines = 3;
+    Screen screen(lines, 20);
+    screen.setScroll(CompactHistoryType(500));
+
+    auto addLines = [&screen](int first, int count) {
+        for (int i = first; i < first + count; ++i) {
+            screen.setCursorYX(lines, 1);
+            const QString text = (i == 900) ? QStringLiteral("a needle") : QStringLiteral("line %1").arg(i);
+            for (const QChar c : text) {
+                screen.displayCharacter(c.unicode());
+            }
+            screen.index();
+        }
+    };
+
+    addLines(0, 300);
+    QVERIFY(!screen.updateHistorySearchIndex(100));
+    QCOMPARE(screen.historySearchIndex().lineCount(), 100);
+
+    // Lines added while the index is built are added by the next slices,
+    // lines dropped from the history are dropped from the index
+    addLines(300, 700);
+    QCOMPARE(screen.getHistLines(), 500);
+    int slices = 0;
+    while (!screen.updateHistorySearchIndex(100)) {
+        QVERIFY(++slices < 10);
+    }
+    QCOMPARE(screen.historySearchIndex().lineCount(), screen.getHistLines());
+
+    // Then lines are added as they are added to the history
+    addLines(1000, 10);
+    QCOMPARE(screen.historySearchIndex().lineCount(), screen.getHistLines());
+
+    // The history holds the lines 508 to 1007, each line goes into it two
+    // lines after it was written
+    int candidates = 0;
+    bool found = false;
+    const QList<QPair<int, int>> ranges = screen.historySearchIndex().candidateLines(QStringLiteral("needle"));
+    for (const auto &[first, last] : ranges) {
+        candidates += last - first + 1;
+        found = found || (first <= 900 - 508 && 900 - 508 <= last);
+    }
+    QVERIFY(found);
+    QVERIFY(candidates < 4 * HistorySearchIndex::BlockLines);
+}
+
+void ScreenTest::testBidiFlags()
+{
+    const int columns = 10;
+    Screen screen(2, columns);
+
+    // Latin, Hebrew, Latin with a right-to-left mark
+    screen.displayCharacter('a');
+    screen.displayCharacter(0x05D0);
+    screen.displayCharacter('b');
+    screen.displayCharacter(0x200F);
+
+    QVector<Character> image(2 * columns);
+    screen.getImage(image.data(), image.size(), 0, 1);
+    QVERIFY((image[0].flags & EF_BIDI) == 0);
+    QVERIFY((image[1].flags & EF_BIDI) != 0);
+    // the mark is combined with the 'b'
+    QVERIFY((image[2].flags & EF_BIDI) != 0);
+    QVERIFY((image[columns].flags & EF_BIDI) == 0);
+}
+
 QTEST_GUILESS_MAIN(ScreenTest)
 
 #include "moc_ScreenTest.cpp"
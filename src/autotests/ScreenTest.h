@@ -24,6 +24,11 @@ private Q_SLOTS:
     void testBlockSelection();
     void testCJKBlockSelection();
     void testCursorPosition();
+    void testDisplayRun();
+    void testTotalDroppedLines();
+    void testLineGenerations();
+    void testHistorySearchIndexSlices();
+    void testBidiFlags();
 
 private:
     void doLargeScreenCopyVerification(const QString &putToScreen, const QString &expectedSelection);
@@ -114,6 +114,24 @@ void Vt102EmulationTest::testParse()
     sendAndCompare(&em, tertiaryDeviceAttributes, sizeof tertiaryDeviceAttributes, QStringLiteral(""), "\033P!|7E4B4445\033\\");
 }
 
+void Vt102EmulationTest::testUtf8Decoding()
+{
+    TestEmulation em;
+    em.reset();
+    em.setCodec(TestEmulation::Utf8Codec);
+
+    // A byte order mark and multi-byte sequences split across reads, and a
+    // malformed byte
+    const char *chunks[] = {"\xef\xbb", "\xbfh\xc3", "\xa9llo \xe2", "\x82", "\xac \xf0\x9f\x98", "\x80 \xff!"};
+    for (const char *chunk : chunks) {
+        em.receiveData(chunk, qstrlen(chunk));
+    }
+
+    QString printed = em._currentScreen->text(0, em._currentScreen->getColumns(), Screen::PlainText);
+    printed.chop(2); // Remove trailing space and newline
+    QCOMPARE(printed, QStringLiteral("h\u00e9llo \u20ac \U0001F600 \uFFFD!"));
+}
+
 Q_DECLARE_METATYPE(std::vector<TestEmulation::Item>)
 
 struct ItemToString {
@@ -26,6 +26,7 @@ private Q_SLOTS:
     void testTokenFunctions();
 
     void testParse();
+    void testUtf8Decoding();
     void testTokenizing_data();
     void testTokenizing();
 
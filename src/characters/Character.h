@@ -141,6 +141,7 @@ const ExtraFlags EF_EMOJI_REPRESENTATION = (1 << 7);
 const ExtraFlags EF_ASCII_WORD = (1 << 8);
 const ExtraFlags EF_BRAHMIC_WORD = (1 << 9);
 const ExtraFlags EF_CODING_WORD = (1 << 10);
+const ExtraFlags EF_BIDI = (1 << 11);
 
 #define SetULColor(f, m) (((f) & ~EF_UNDERLINE_COLOR) | ((m) * EF_UNDERLINE_COLOR_1))
 #define setRepl(f, m) (((f) & ~EF_REPL) | ((m) * EF_REPL_PROMPT))
@@ -310,6 +311,21 @@ public:
         return false;
     }
 
+    /**
+     * Returns true if @p ucs4 is a right-to-left or Arabic character, or a
+     * bidirectional formatting character.  A line without such characters is
+     * displayed from left to right without reordering or shaping.
+     */
+    static bool bidi(uint ucs4)
+    {
+        if (ucs4 < 0x0590) {
+            return false;
+        }
+        return ucs4 <= 0x08ff || (ucs4 >= 0x200e && ucs4 <= 0x200f) || (ucs4 >= 0x202a && ucs4 <= 0x202e) || (ucs4 >= 0x2066 && ucs4 <= 0x2069)
+            || (ucs4 >= 0xfb1d && ucs4 <= 0xfdff) || (ucs4 >= 0xfe70 && ucs4 <= 0xfefe) || (ucs4 >= 0x10800 && ucs4 <= 0x10fff)
+            || (ucs4 >= 0x1e800 && ucs4 <= 0x1efff);
+    }
+
     static int width(uint ucs4, bool ignoreWcWidth = false)
     {
         // ASCII
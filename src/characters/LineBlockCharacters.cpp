@@ -12,6 +12,7 @@
 
 // Qt
 #include <QPainterPath>
+#include <QtMath>
 
 namespace Konsole
 {
@@ -867,5 +868,92 @@ void draw(QPainter &paint, const QRect &cellRect, const uint &chr, bool bold)
         || drawBlockCharacter(paint, x, y, w, h, code, bold);
 }
 
+static int atlasCell(uint chr)
+{
+    if (chr >= 0x1fb00) {
+        return 0xa0 + 0x100 + int(chr - 0x1fb00);
+    } else if (chr >= 0x2800) {
+        return 0xa0 + int(chr - 0x2800);
+    }
+    return int(chr) - 0x2500;
+}
+
+GlyphAtlas::GlyphAtlas()
+    : _pages(MaxColors)
+{
+}
+
+// Returns true if @p value is a whole number of device pixels
+static bool isWholePixels(qreal value)
+{
+    return qFuzzyCompare(value + 1, qRound(value) + 1);
+}
+
+void GlyphAtlas::draw(QPainter &paint, const QRect &cellRect, uint chr, bool bold)
+{
+    const int cell = atlasCell(chr);
+    // Scaled characters, on double width and double height lines, and
+    // printed characters are drawn sharper with paths than from images
+    const int deviceType = paint.device()->devType();
+    if (cell < 0 || cell >= Cells || paint.worldTransform().type() > QTransform::TxTranslate || deviceType == QInternal::Printer
+        || deviceType == QInternal::Picture) {
+        LineBlockCharacters::draw(paint, cellRect, chr, bold);
+        return;
+    }
+
+    // With fractional scale factors the cells don't start and end on device
+    // pixels, so an image of a cell would be resampled and the lines wouldn't
+    // join; paths are drawn at device resolution instead
+    const qreal devicePixelRatio = paint.device()->devicePixelRatioF();
+    const QPointF deviceTopLeft = paint.worldTransform().map(QPointF(cellRect.topLeft())) * devicePixelRatio;
+    if (!isWholePixels(deviceTopLeft.x()) || !isWholePixels(deviceTopLeft.y()) || !isWholePixels(cellRect.width() * devicePixelRatio)
+        || !isWholePixels(cellRect.height() * devicePixelRatio)) {
+        LineBlockCharacters::draw(paint, cellRect, chr, bold);
+        return;
+    }
+
+    const bool antialias = paint.testRenderHint(QPainter::Antialiasing);
+    if (cellRect.size() != _cellSize || devicePixelRatio != _devicePixelRatio || antialias != _antialias) {
+        clear();
+        _cellSize = cellRect.size();
+        _devicePixelRatio = devicePixelRatio;
+        _antialias = antialias;
+    }
+
+    const QColor color = paint.pen().color();
+    const quint64 key = (quint64(color.rgba()) << 1) | (bold ? 1 : 0);
+    Pages *pages = _pages.object(key);
+    if (pages == nullptr) {
+        pages = new Pages;
+        _pages.insert(key, pages);
+    }
+
+    Page &page = (*pages)[cell / PageCells];
+    const int index = cell % PageCells;
+    const int pixelWidth = qRound(_cellSize.width() * devicePixelRatio);
+    const int pixelHeight = qRound(_cellSize.height() * devicePixelRatio);
+
+    if (page.pixmap.isNull()) {
+        page.pixmap = QPixmap(PageCells * pixelWidth, pixelHeight);
+        page.pixmap.setDevicePixelRatio(devicePixelRatio);
+        page.pixmap.fill(Qt::transparent);
+    }
+    if ((page.drawn & (1u << index)) == 0) {
+        QPainter painter(&page.pixmap);
+        painter.setRenderHint(QPainter::Antialiasing, antialias);
+        painter.setPen(QPen(color));
+        painter.translate(index * pixelWidth / devicePixelRatio, 0);
+        LineBlockCharacters::draw(painter, QRect(QPoint(0, 0), _cellSize), chr, bold);
+        page.drawn |= 1u << index;
+    }
+
+    paint.drawPixmap(QRectF(cellRect), page.pixmap, QRectF(index * pixelWidth, 0, pixelWidth, pixelHeight));
+}
+
+void GlyphAtlas::clear()
+{
+    _pages.clear();
+}
+
 } // namespace LineBlockCharacters
 } // namespace Konsole
@@ -8,7 +8,12 @@
 #define LINEBLOCKCHARACTERS_H
 
 // Qt
+#include <QCache>
 #include <QPainter>
+#include <QPixmap>
+
+// STD
+#include <array>
 
 namespace Konsole
 {
@@ -52,6 +57,58 @@ inline static bool isLegacyComputingSymbol(uint ucs4cp)
  */
 void draw(QPainter &paint, const QRect &cellRect, const uint &chr, bool bold);
 
+/**
+ * Draws characters like draw() does, by copying them from images where they
+ * were drawn once for each pen color, weight and cell size.
+ *
+ * The images are pages of PageCells characters, which are allocated when one
+ * of their characters is first drawn, so only the pages of the characters in
+ * use take memory.  Only the pages of the most recently used colors and
+ * weights are kept.  Cells which don't fall on whole device pixels, at
+ * fractional scale factors, are drawn with draw() instead.
+ */
+class GlyphAtlas
+{
+public:
+    GlyphAtlas();
+
+    /**
+     * Draws character with the color of the pen of @p paint.
+     *
+     * @param paint QPainter to draw on
+     * @param cellRect Rectangle to draw in
+     * @param chr Character to be drawn
+     * @param bold Whether the character should be boldface
+     */
+    void draw(QPainter &paint, const QRect &cellRect, uint chr, bool bold);
+
+    /** Removes all the drawn characters */
+    void clear();
+
+private:
+    static constexpr int PageCells = 32;
+    // Box Drawing and Block Elements, Braille Patterns, Legacy Computing Symbols
+    static constexpr int Cells = 0xa0 + 0x100 + 0x8c;
+
+    struct Page {
+        QPixmap pixmap;
+        // bit set of the cells which were drawn
+        quint32 drawn = 0;
+    };
+    using Pages = std::array<Page, (Cells + PageCells - 1) / PageCells>;
+
+    // Number of pen colors and weights for which characters are kept
+    static constexpr int MaxColors = 16;
+
+    // pages for each pen color and weight, the least recently used ones are
+    // removed when there are more than MaxColors
+    QCache<quint64, Pages> _pages;
+
+    QSize _cellSize;
+    qreal _devicePixelRatio = 1;
+    bool _antialias = false;
+};
+
 } // namespace LineBlockCharacters
 } // namespace Konsole
 
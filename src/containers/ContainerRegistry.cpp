@@ -18,6 +18,10 @@
 
 #include <KLocalizedString>
 #include <KSandbox>
+#include <QFile>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QThreadPool>
 #include <optional>
 #include <qglobalstatic.h>
 
@@ -25,12 +29,34 @@ namespace Konsole
 {
 Q_GLOBAL_STATIC(ContainerRegistry, registry)
 
+// Number of processes whose container is remembered by detectContainerAsync()
+static const int DETECTED_CONTAINERS_CACHE_SIZE = 256;
+
+// Returns the time the process started at, in clock ticks after boot, or 0
+// if it doesn't exist
+static quint64 processStartTime(int pid)
+{
+    QFile statFile(QStringLiteral("/proc/%1/stat").arg(pid));
+    if (!statFile.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    // The start time is the 20th field after the name, which is in
+    // parentheses and may contain spaces
+    const QByteArray data = statFile.readAll();
+    const QList<QByteArray> fields = data.mid(data.lastIndexOf(')') + 1).split(' ');
+    // the first field is empty, as the fields are preceded by a space
+    const int START_TIME_FIELD = 20;
+    return fields.size() > START_TIME_FIELD ? fields[START_TIME_FIELD].toULongLong() : 0;
+}
+
 ContainerRegistry *ContainerRegistry::instance()
 {
     return registry;
 }
 
 ContainerRegistry::ContainerRegistry()
+    : _detectedContainers(DETECTED_CONTAINERS_CACHE_SIZE)
 {
     qDebug(KonsoleDebug) << "ContainerRegistry created";
     // Check for Flatpak environment - disable container support if detected
@@ -120,6 +146,48 @@ ContainerInfo ContainerRegistry::detectContainer(int pid) const
     return ContainerInfo{};
 }
 
+void ContainerRegistry::detectContainerAsync(int pid, QObject *context, const std::function<void(const ContainerInfo &)> &callback)
+{
+    if (!_enabled || pid <= 0) {
+        callback(ContainerInfo{});
+        return;
+    }
+
+    // Even the start time is read in the worker, so the GUI thread doesn't
+    // wait for /proc. The detectors only read files, and aren't changed once
+    // registered.
+    QThreadPool::globalInstance()->start([this, pid, context = QPointer<QObject>(context), callback]() {
+        ContainerInfo container;
+        // 0 if the process already exited
+        const quint64 startTime = processStartTime(pid);
+        if (startTime != 0) {
+            const ProcessKey key{pid, startTime};
+            std::optional<ContainerInfo> detected;
+            {
+                QMutexLocker locker(&_detectedContainersMutex);
+                if (const ContainerInfo *cached = _detectedContainers.object(key)) {
+                    detected = *cached;
+                }
+            }
+            if (!detected) {
+                detected = detectContainer(pid);
+                QMutexLocker locker(&_detectedContainersMutex);
+                _detectedContainers.insert(key, new ContainerInfo(*detected));
+            }
+            container = *detected;
+        }
+
+        QMetaObject::invokeMethod(
+            this,
+            [container, context, callback]() {
+                if (!context.isNull()) {
+                    callback(container);
+                }
+            },
+            Qt::QueuedConnection);
+    });
+}
+
 QStringList ContainerRegistry::entryCommand(const ContainerInfo &container) const
 {
     if (!_enabled || !container.isValid()) {
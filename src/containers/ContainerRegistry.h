@@ -11,11 +11,14 @@
 #include "IContainerDetector.h"
 #include "konsoleprivate_export.h"
 
+#include <QCache>
 #include <QList>
+#include <QMutex>
 #include <QObject>
 #include <QString>
 #include <QStringList>
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -83,6 +86,22 @@ public:
      */
     ContainerInfo detectContainer(int pid) const;
 
+    /**
+     * Detect the container of the given process like detectContainer(),
+     * in a worker thread.
+     *
+     * The container of a process doesn't change, so the result is
+     * remembered per process until it exits, and later calls for the same
+     * process return it without detecting again.
+     *
+     * @param pid Process ID to check
+     * @param context The callback isn't called if it is destroyed before the
+     *                detection finished
+     * @param callback Called with the result in the thread of the registry,
+     *                 right away if container support is disabled
+     */
+    void detectContainerAsync(int pid, QObject *context, const std::function<void(const ContainerInfo &)> &callback);
+
     /**
      * Get the command to enter a specific container.
      *
@@ -174,6 +193,26 @@ private:
     QList<ContainerInfo> _cachedContainers;
     QList<ContainerInfo> _pendingResults;
 
+    // The results of detectContainerAsync(), per process. The start time
+    // tells a process apart from a later one with the same ID.
+    struct ProcessKey {
+        int pid;
+        quint64 startTime;
+
+        bool operator==(const ProcessKey &other) const
+        {
+            return pid == other.pid && startTime == other.startTime;
+        }
+
+        friend size_t qHash(const ProcessKey &key, size_t seed = 0) noexcept
+        {
+            return qHashMulti(seed, key.pid, key.startTime);
+        }
+    };
+    // Used by the workers of detectContainerAsync()
+    QCache<ProcessKey, ContainerInfo> _detectedContainers;
+    QMutex _detectedContainersMutex;
+
     Q_DISABLE_COPY(ContainerRegistry)
 };
 
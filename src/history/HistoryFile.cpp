@@ -9,7 +9,6 @@
 
 // Konsole
 #include "KonsoleSettings.h"
-#include "characters/Character.h"
 #include "konsoledebug.h"
 
 // System
@@ -31,13 +30,10 @@ using namespace Konsole;
 Q_GLOBAL_STATIC(QString, historyFileLocation)
 
 // History File ///////////////////////////////////////////
-HistoryFile::HistoryFile()
-    : _length(0)
-    , _fileMap(nullptr)
-    , _readWriteBalance(0)
+HistoryFile::HistoryFile(int streamCount)
+    : _streams(streamCount)
 {
     // Determine the temp directory once
-    // This class is called 3 times for each "unlimited" scrollback.
     // This has the down-side that users must restart to
     // load changes.
     if (!historyFileLocation.exists()) {
@@ -104,145 +100,172 @@ HistoryFile::HistoryFile()
 
 HistoryFile::~HistoryFile()
 {
-    if (_fileMap != nullptr) {
-        unmap();
+    for (const Segment &segment : _segments) {
+        if (segment.map != nullptr) {
+            _tmpFile.unmap(segment.map);
+        }
     }
 }
 
-// TODO:  Mapping the entire file in will cause problems if the history file becomes exceedingly large,
-//(ie. larger than available memory).  HistoryFile::map() should only map in sections of the file at a time,
-// to avoid this.
-void HistoryFile::map()
+int HistoryFile::allocateSegment()
 {
-    Q_ASSERT(_fileMap == nullptr);
+    if (!_freeSegments.empty()) {
+        const int index = _freeSegments.back();
+        _freeSegments.pop_back();
+        return index;
+    }
 
-    if (_tmpFile.flush()) {
-        Q_ASSERT(_tmpFile.size() >= _length);
-        _fileMap = _tmpFile.map(0, _length);
+    const qint64 offset = qint64(_segments.size()) * SEGMENT_SIZE;
+    if (!_tmpFile.resize(offset + SEGMENT_SIZE)) {
+        qCDebug(KonsoleDebug) << "Resizing history file failed:" << _tmpFile.errorString();
+        return -1;
     }
 
+    Segment segment;
+    segment.map = _tmpFile.map(offset, SEGMENT_SIZE);
+
     // if mmap'ing fails, fall back to the read-lseek combination
-    if (_fileMap == nullptr) {
-        _readWriteBalance = 0;
+    if (segment.map == nullptr) {
         qCDebug(KonsoleDebug) << "mmap'ing history failed.  errno = " << errno;
     }
+
+    _segments.push_back(segment);
+    return _segments.size() - 1;
 }
 
-void HistoryFile::unmap()
+void HistoryFile::add(int stream, const char *buffer, qint64 count)
 {
-    Q_ASSERT(_fileMap != nullptr);
-
-    if (_tmpFile.unmap(_fileMap)) {
-        _fileMap = nullptr;
-    }
+    Stream &s = _streams[stream];
 
-    Q_ASSERT(_fileMap == nullptr);
-}
+    while (count > 0) {
+        const qint64 offset = s.length % SEGMENT_SIZE;
+        if (offset == 0 && s.length / SEGMENT_SIZE == qint64(s.segments.size())) {
+            const int segment = allocateSegment();
+            if (segment < 0) {
+                return;
+            }
+            s.segments.push_back(segment);
+        }
 
-void HistoryFile::add(const char *buffer, qint64 count)
-{
-    if (_fileMap != nullptr) {
-        unmap();
-    }
+        const qint64 n = qMin(count, SEGMENT_SIZE - offset);
+        const int segment = s.segments[s.length / SEGMENT_SIZE];
+        if (_segments[segment].map != nullptr) {
+            memcpy(_segments[segment].map + offset, buffer, n);
+        } else {
+            if (!_tmpFile.seek(segment * SEGMENT_SIZE + offset)) {
+                perror("HistoryFile::add.seek");
+                return;
+            }
+            if (_tmpFile.write(buffer, n) < 0) {
+                perror("HistoryFile::add.write");
+                return;
+            }
+        }
 
-    if (_readWriteBalance < INT_MAX) {
-        _readWriteBalance++;
+        s.length += n;
+        buffer += n;
+        count -= n;
     }
+}
 
-    qint64 rc = 0;
+void HistoryFile::copy(const Stream &stream, char *buffer, qint64 size, qint64 loc) const
+{
+    while (size > 0) {
+        const qint64 offset = loc % SEGMENT_SIZE;
+        const qint64 n = qMin(size, SEGMENT_SIZE - offset);
+        const int segment = stream.segments[loc / SEGMENT_SIZE];
+        if (_segments[segment].map != nullptr) {
+            memcpy(buffer, _segments[segment].map + offset, n);
+        } else {
+            if (!_tmpFile.seek(segment * SEGMENT_SIZE + offset)) {
+                perror("HistoryFile::get.seek");
+                return;
+            }
+            if (_tmpFile.read(buffer, n) < 0) {
+                perror("HistoryFile::get.read");
+                return;
+            }
+        }
 
-    if (!_tmpFile.seek(_length)) {
-        perror("HistoryFile::add.seek");
-        return;
+        loc += n;
+        buffer += n;
+        size -= n;
     }
-    rc = _tmpFile.write(buffer, count);
-    if (rc < 0) {
-        perror("HistoryFile::add.write");
-        return;
-    }
-    _length += rc;
 }
 
-void HistoryFile::get(char *buffer, qint64 size, qint64 loc)
+void HistoryFile::get(int stream, char *buffer, qint64 size, qint64 loc) const
 {
-    if (loc < 0 || size < 0 || loc + size > (qint64)(_length * sizeof(LineProperty))) {
+    const Stream &s = _streams[stream];
+    if (loc < 0 || size < 0 || loc + size > s.length) {
         fprintf(stderr, "getHist(...,%lld,%lld): invalid args.\n", size, loc);
         return;
     }
 
-    // count number of get() calls vs. number of add() calls.
-    // If there are many more get() calls compared with add()
-    // calls (decided by using MAP_THRESHOLD) then mmap the log
-    // file to improve performance.
-    if (_readWriteBalance > INT_MIN) {
-        _readWriteBalance--;
-    }
-    if ((_fileMap == nullptr) && _readWriteBalance < MAP_THRESHOLD) {
-        map();
-    }
-
-    if (_fileMap != nullptr) {
-        memcpy(buffer, _fileMap + loc, size);
-    } else {
-        qint64 rc = 0;
-
-        if (!_tmpFile.seek(loc)) {
-            perror("HistoryFile::get.seek");
-            return;
-        }
-        rc = _tmpFile.read(buffer, size);
-        if (rc < 0) {
-            perror("HistoryFile::get.read");
-            return;
-        }
-    }
+    copy(s, buffer, size, loc);
 }
 
-void HistoryFile::set(char *buffer, qint64 size, qint64 loc)
+void HistoryFile::set(int stream, const char *buffer, qint64 size, qint64 loc)
 {
-    if (loc < 0 || size < 0 || loc + size > qint64(_length * sizeof(LineProperty))) {
+    Stream &s = _streams[stream];
+    if (loc < 0 || size < 0 || loc + size > s.length) {
         fprintf(stderr, "setHist(...,%lld,%lld): invalid args.\n", size, loc);
         return;
     }
 
-    // count number of get() calls vs. number of add() calls.
-    // If there are many more get() calls compared with add()
-    // calls (decided by using MAP_THRESHOLD) then mmap the log
-    // file to improve performance.
-    if (_readWriteBalance > INT_MIN) {
-        _readWriteBalance--;
-    }
-    if ((_fileMap == nullptr) && _readWriteBalance < MAP_THRESHOLD) {
-        map();
+    while (size > 0) {
+        const qint64 offset = loc % SEGMENT_SIZE;
+        const qint64 n = qMin(size, SEGMENT_SIZE - offset);
+        const int segment = s.segments[loc / SEGMENT_SIZE];
+        if (_segments[segment].map != nullptr) {
+            memcpy(_segments[segment].map + offset, buffer, n);
+        } else {
+            if (!_tmpFile.seek(segment * SEGMENT_SIZE + offset)) {
+                perror("HistoryFile::set.seek");
+                return;
+            }
+            if (_tmpFile.write(buffer, n) < 0) {
+                perror("HistoryFile::set.write");
+                return;
+            }
+        }
+
+        loc += n;
+        buffer += n;
+        size -= n;
     }
+}
 
-    if (_fileMap != nullptr) {
-        memcpy(_fileMap + loc, buffer, size);
-    } else {
-        qint64 rc = 0;
+const char *HistoryFile::data(int stream, qint64 loc, qint64 size) const
+{
+    const Stream &s = _streams[stream];
+    Q_ASSERT(loc >= 0 && size >= 0 && loc + size <= s.length);
 
-        if (!_tmpFile.seek(loc)) {
-            perror("HistoryFile::set.seek");
-            return;
-        }
-        rc = _tmpFile.write(buffer, size);
-        if (rc < 0) {
-            perror("HistoryFile::set.write");
-            return;
-        }
+    const qint64 offset = loc % SEGMENT_SIZE;
+    if (size == 0 || offset + size > SEGMENT_SIZE) {
+        return nullptr;
     }
+    const uchar *map = _segments[s.segments[loc / SEGMENT_SIZE]].map;
+    return map != nullptr ? reinterpret_cast<const char *>(map + offset) : nullptr;
 }
 
-void HistoryFile::removeLast(qint64 loc)
+void HistoryFile::removeLast(int stream, qint64 loc)
 {
-    if (loc < 0 || loc > _length) {
+    Stream &s = _streams[stream];
+    if (loc < 0 || loc > s.length) {
         fprintf(stderr, "removeLast(%lld): invalid args.\n", loc);
         return;
     }
-    _length = loc;
+    s.length = loc;
+
+    // Give the segments which are no longer used back for reuse
+    const size_t usedSegments = (loc + SEGMENT_SIZE - 1) / SEGMENT_SIZE;
+    while (s.segments.size() > usedSegments) {
+        _freeSegments.push_back(s.segments.back());
+        s.segments.pop_back();
+    }
 }
 
-qint64 HistoryFile::len() const
+qint64 HistoryFile::len(int stream) const
 {
-    return _length;
+    return _streams[stream].length;
 }
@@ -10,45 +10,61 @@
 // Qt
 #include <QTemporaryFile>
 
+// STD
+#include <vector>
+
 #include "konsoleprivate_export.h"
 
 namespace Konsole
 {
 /*
-   An extendable tmpfile(1) based buffer.
+   An extendable tmpfile(1) based buffer, holding one or more streams of bytes.
+
+   The file is made of fixed-size segments, each of which is mmap'ed when it is
+   allocated, so reading and writing is a memcpy() and the file only needs to be
+   resized when a new segment is allocated.  Each stream owns a list of segments;
+   segments freed by removeLast() are reused by the next stream that grows.
+   If mmap'ing fails, segments fall back to the seek-read/write combination.
 */
 class HistoryFile
 {
 public:
-    HistoryFile();
-    virtual ~HistoryFile();
+    explicit HistoryFile(int streamCount = 1);
+    ~HistoryFile();
 
-    virtual void add(const char *buffer, qint64 count);
-    virtual void get(char *buffer, qint64 size, qint64 loc);
-    virtual void set(char *buffer, qint64 size, qint64 loc);
-    virtual void removeLast(qint64 loc);
-    virtual qint64 len() const;
+    void add(int stream, const char *buffer, qint64 count);
+    void get(int stream, char *buffer, qint64 size, qint64 loc) const;
+    void set(int stream, const char *buffer, qint64 size, qint64 loc);
+    void removeLast(int stream, qint64 loc);
+    qint64 len(int stream) const;
 
-    // mmaps the file in read-only mode
-    void map();
-    // un-mmaps the file
-    void unmap();
+    // Returns a pointer to the @p size bytes at @p loc of @p stream, or nullptr
+    // if they are not contiguous in memory, in which case get() must be used
+    const char *data(int stream, qint64 loc, qint64 size) const;
+
+    static const qint64 SEGMENT_SIZE = 1 << 20;
 
 private:
-    qint64 _length;
-    QTemporaryFile _tmpFile;
+    Q_DISABLE_COPY(HistoryFile)
+
+    struct Stream {
+        // indexes into _segments
+        std::vector<int> segments;
+        qint64 length = 0;
+    };
 
-    // pointer to start of mmap'ed file data, or 0 if the file is not mmap'ed
-    uchar *_fileMap;
+    struct Segment {
+        // pointer to the mmap'ed segment, or nullptr if it is not mmap'ed
+        uchar *map = nullptr;
+    };
 
-    // incremented whenever 'add' is called and decremented whenever
-    //'get' is called.
-    // this is used to detect when a large number of lines are being read and processed from the history
-    // and automatically mmap the file for better performance (saves the overhead of many lseek-read calls).
-    int _readWriteBalance;
+    int allocateSegment();
+    void copy(const Stream &stream, char *buffer, qint64 size, qint64 loc) const;
 
-    // when _readWriteBalance goes below this threshold, the file will be mmap'ed automatically
-    static const int MAP_THRESHOLD = -1000;
+    mutable QTemporaryFile _tmpFile;
+    std::vector<Stream> _streams;
+    std::vector<Segment> _segments;
+    std::vector<int> _freeSegments;
 };
 
 }
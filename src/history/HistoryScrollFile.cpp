@@ -7,22 +7,25 @@
 #include "HistoryScrollFile.h"
 
 #include "HistoryTypeFile.h"
+#include "compact/CellBlockStore.h"
 
 /*
    The history scroll makes a Row(Row(Cell)) from
-   two history buffers. The index buffer contains
-   start of line positions which refer to the cells
-   buffer.
-
-   Note that index[0] addresses the second line
-   (line #1), while the first line (line #0) starts
-   at 0 in cells.
+   two streams of a history file. The cells stream holds
+   the cells of all lines, back to back, in the encoding
+   of CellBlockStore (uncompressed), and the index stream
+   holds, for each line, the position of its first cell,
+   its length and its properties.
+
+   A line may start in the middle of an encoded chunk when
+   reflowLines() has split a longer line.
 */
 
 using namespace Konsole;
 
 HistoryScrollFile::HistoryScrollFile()
     : HistoryScroll(new HistoryTypeFile())
+    , _file(StreamCount)
 {
 }
 
@@ -30,7 +33,7 @@ HistoryScrollFile::~HistoryScrollFile() = default;
 
 int HistoryScrollFile::getLines() const
 {
-    return _index.len() / sizeof(qint64);
+    return _file.len(IndexStream) / sizeof(IndexEntry);
 }
 
 int HistoryScrollFile::getMaxLines() const
@@ -38,9 +41,18 @@ int HistoryScrollFile::getMaxLines() const
     return getLines();
 }
 
+HistoryScrollFile::IndexEntry HistoryScrollFile::indexEntry(const int lineno) const
+{
+    IndexEntry entry = {{0, 0}, 0, LineProperty()};
+    if (lineno >= 0 && lineno < getLines()) {
+        _file.get(IndexStream, reinterpret_cast<char *>(&entry), sizeof(IndexEntry), lineno * sizeof(IndexEntry));
+    }
+    return entry;
+}
+
 int HistoryScrollFile::getLineLen(const int lineno) const
 {
-    return (startOfLine(lineno + 1) - startOfLine(lineno)) / sizeof(Character);
+    return indexEntry(lineno).count;
 }
 
 bool HistoryScrollFile::isWrappedLine(const int lineno) const
@@ -50,130 +62,165 @@ bool HistoryScrollFile::isWrappedLine(const int lineno) const
 
 LineProperty HistoryScrollFile::getLineProperty(const int lineno) const
 {
-    if (lineno >= 0 && lineno <= getLines()) {
-        LineProperty flag = LineProperty();
-        _lineflags.get(reinterpret_cast<char *>(&flag), sizeof(LineProperty), (lineno) * sizeof(LineProperty));
-        return flag;
-    }
-    return LineProperty();
+    return indexEntry(lineno).property;
 }
 
 void HistoryScrollFile::setLineProperty(const int lineno, LineProperty prop)
 {
-    if (lineno >= 0 && lineno <= getLines()) {
-        _lineflags.set(reinterpret_cast<char *>(&prop), sizeof(LineProperty), (lineno) * sizeof(LineProperty));
+    if (lineno >= 0 && lineno < getLines()) {
+        _file.set(IndexStream, reinterpret_cast<char *>(&prop), sizeof(LineProperty), lineno * sizeof(IndexEntry) + offsetof(IndexEntry, property));
     }
 }
 
-qint64 HistoryScrollFile::startOfLine(const int lineno) const
+const char *HistoryScrollFile::chunk(qint64 loc, int *cellCount, qsizetype *size) const
 {
-    Q_ASSERT(lineno >= 0 && lineno <= getLines());
+    char header[CellBlockStore::EncodedHeaderSize];
+    const char *data = _file.data(CellsStream, loc, sizeof(header));
+    if (data == nullptr) {
+        _file.get(CellsStream, header, sizeof(header), loc);
+        data = header;
+    }
+    *size = CellBlockStore::encodedChunkSize(data, cellCount);
 
-    if (lineno == 0) {
-        return 0;
+    data = _file.data(CellsStream, loc, *size);
+    if (data == nullptr) {
+        _scratch.resize(*size);
+        _file.get(CellsStream, _scratch.data(), *size, loc);
+        data = _scratch.constData();
     }
-    if (lineno < getLines()) {
-        qint64 res = 0;
-        _index.get(reinterpret_cast<char *>(&res), sizeof(qint64), (lineno - 1) * sizeof(qint64));
-        return res;
+    return data;
+}
+
+HistoryScrollFile::CellPosition HistoryScrollFile::advance(CellPosition position, int count) const
+{
+    count += position.skip;
+    while (count > 0 && position.chunk < _file.len(CellsStream)) {
+        char header[CellBlockStore::EncodedHeaderSize];
+        _file.get(CellsStream, header, sizeof(header), position.chunk);
+        int cellCount = 0;
+        const qsizetype size = CellBlockStore::encodedChunkSize(header, &cellCount);
+        if (count < cellCount) {
+            break;
+        }
+        count -= cellCount;
+        position.chunk += size;
     }
-    return _cells.len();
+    position.skip = count;
+    return position;
 }
 
 void HistoryScrollFile::getCells(const int lineno, const int colno, const int count, Character res[]) const
 {
-    _cells.get(reinterpret_cast<char *>(res), count * sizeof(Character), startOfLine(lineno) + colno * sizeof(Character));
+    const IndexEntry entry = indexEntry(lineno);
+    Q_ASSERT(colno >= 0 && colno + count <= entry.count);
+
+    qint64 loc = entry.start.chunk;
+    int skip = entry.start.skip + colno;
+    int remaining = count;
+    while (remaining > 0) {
+        int cellCount = 0;
+        qsizetype size = 0;
+        const char *data = chunk(loc, &cellCount, &size);
+        if (skip < cellCount) {
+            const int n = qMin(remaining, cellCount - skip);
+            CellBlockStore::decode(data, skip, n, res);
+            res += n;
+            remaining -= n;
+            skip = 0;
+        } else {
+            skip -= cellCount;
+        }
+        loc += size;
+    }
 }
 
 void HistoryScrollFile::addCells(const Character text[], const int count)
 {
-    _cells.add(reinterpret_cast<const char *>(text), count * sizeof(Character));
+    if (count <= 0) {
+        return;
+    }
+
+    _scratch.resize(0);
+    CellBlockStore::encode(text, count, _scratch);
+    _file.add(CellsStream, _scratch.constData(), _scratch.size());
+    _pendingCount += count;
 }
 
 void HistoryScrollFile::addLine(LineProperty lineProperty)
 {
-    qint64 locn = _cells.len();
-    _index.add(reinterpret_cast<char *>(&locn), sizeof(qint64));
-    _lineflags.add(reinterpret_cast<char *>(&lineProperty), sizeof(LineProperty));
+    const IndexEntry entry = {{_pendingStart, 0}, _pendingCount, lineProperty};
+    _file.add(IndexStream, reinterpret_cast<const char *>(&entry), sizeof(IndexEntry));
+
+    _pendingStart = _file.len(CellsStream);
+    _pendingCount = 0;
 }
 
 void HistoryScrollFile::removeCells()
 {
-    qint64 res = (getLines() - 2) * sizeof(qint64);
-    if (getLines() < 2) {
-        _cells.removeLast(0);
+    const int lines = getLines();
+    if (lines == 0) {
+        _file.removeLast(CellsStream, 0);
     } else {
-        _index.get(reinterpret_cast<char *>(&res), sizeof(qint64), res);
-        _cells.removeLast(res);
+        const IndexEntry entry = indexEntry(lines - 1);
+        if (entry.start.skip > 0) {
+            // The previous line ends in the first chunk of this one; keep its
+            // cells, so the lines stay back to back for reflowLines()
+            int cellCount = 0;
+            qsizetype size = 0;
+            std::vector<Character> kept(entry.start.skip);
+            CellBlockStore::decode(chunk(entry.start.chunk, &cellCount, &size), 0, entry.start.skip, kept.data());
+            _file.removeLast(CellsStream, entry.start.chunk);
+            _scratch.resize(0);
+            CellBlockStore::encode(kept.data(), kept.size(), _scratch);
+            _file.add(CellsStream, _scratch.constData(), _scratch.size());
+        } else {
+            _file.removeLast(CellsStream, entry.start.chunk);
+        }
+        _file.removeLast(IndexStream, (lines - 1) * sizeof(IndexEntry));
     }
-    res = qMax(0, getLines() - 1);
-    _index.removeLast(res * sizeof(qint64));
-    _lineflags.removeLast(res * sizeof(LineProperty));
+
+    _pendingStart = _file.len(CellsStream);
+    _pendingCount = 0;
 }
 
 int Konsole::HistoryScrollFile::reflowLines(const int columns, std::map<int, int> *)
 {
-    auto reflowFile = std::make_unique<HistoryFile>();
-    reflowData newLine;
-
-    auto reflowLineLen = [](qint64 start, qint64 end) {
-        return (int)((end - start) / sizeof(Character));
-    };
-    auto setNewLine = [](reflowData &change, qint64 index, LineProperty lineflag) {
-        change.index = index;
-        change.lineFlag = lineflag;
-    };
-
-    // First all changes are saved on an auxiliary file, no real index is changed
+    // First all changes are saved in memory, no real index is changed
+    std::vector<IndexEntry> reflowed;
+
     int currentPos = 0;
     if (getLines() > MAX_REFLOW_LINES) {
         currentPos = getLines() - MAX_REFLOW_LINES;
     }
+    const int firstPos = currentPos;
     while (currentPos < getLines()) {
-        qint64 startLine = startOfLine(currentPos);
-        qint64 endLine = startOfLine(currentPos + 1);
-        LineProperty lineProperty = getLineProperty(currentPos);
+        const IndexEntry entry = indexEntry(currentPos);
+        CellPosition start = entry.start;
+        int lineLen = entry.count;
+        LineProperty lineProperty = entry.property;
 
         // Join the lines if they are wrapped
         while (currentPos < getLines() - 1 && isWrappedLine(currentPos)) {
             currentPos++;
-            endLine = startOfLine(currentPos + 1);
+            lineLen += getLineLen(currentPos);
         }
 
         // Now reflow the lines
-        while (reflowLineLen(startLine, endLine) > columns && !(lineProperty.flags.f.doubleheight_bottom | lineProperty.flags.f.doubleheight_top)) {
-            startLine += (qint64)columns * sizeof(Character);
+        while (lineLen > columns && !(lineProperty.flags.f.doubleheight_bottom | lineProperty.flags.f.doubleheight_top)) {
             lineProperty.flags.f.wrapped = 1;
-            setNewLine(newLine, startLine, lineProperty);
+            reflowed.push_back({start, columns, lineProperty});
+            start = advance(start, columns);
+            lineLen -= columns;
             lineProperty.resetStarts();
-            reflowFile->add(reinterpret_cast<const char *>(&newLine), sizeof(reflowData));
         }
         lineProperty.flags.f.wrapped = 0;
-        setNewLine(newLine, endLine, lineProperty);
-        reflowFile->add(reinterpret_cast<const char *>(&newLine), sizeof(reflowData));
+        reflowed.push_back({start, lineLen, lineProperty});
         currentPos++;
     }
 
-    // Erase data from index and flag data
-    if (getLines() > MAX_REFLOW_LINES) {
-        currentPos = getLines() - MAX_REFLOW_LINES;
-        _index.removeLast(currentPos * sizeof(qint64));
-        _lineflags.removeLast(currentPos * sizeof(LineProperty));
-    } else {
-        _index.removeLast(0);
-        _lineflags.removeLast(0);
-    }
-
-    // Now save the new indexes and properties to proper files
-    int totalLines = reflowFile->len() / sizeof(reflowData);
-    currentPos = 0;
-    while (currentPos < totalLines) {
-        reflowFile->get(reinterpret_cast<char *>(&newLine), sizeof(reflowData), currentPos * sizeof(reflowData));
-
-        _lineflags.add(reinterpret_cast<char *>(&newLine.lineFlag), sizeof(LineProperty));
-        _index.add(reinterpret_cast<char *>(&newLine.index), sizeof(qint64));
-        currentPos++;
-    }
+    // Replace the index of the reflowed lines
+    _file.removeLast(IndexStream, firstPos * sizeof(IndexEntry));
+    _file.add(IndexStream, reinterpret_cast<const char *>(reflowed.data()), reflowed.size() * sizeof(IndexEntry));
 
     return 0;
 }
@@ -45,16 +45,34 @@ public:
     int reflowLines(const int columns, std::map<int, int> * = nullptr) override;
 
 private:
-    qint64 startOfLine(const int lineno) const;
-
-    mutable HistoryFile _index; // lines Row(qint64)
-    mutable HistoryFile _cells; // text  Row(Character)
-    mutable HistoryFile _lineflags; // flags Row(unsigned char)
+    // Position of a cell in the cells stream: the encoded chunk which holds
+    // it, and the number of cells before it in that chunk
+    struct CellPosition {
+        qint64 chunk;
+        qint32 skip;
+    };
 
-    struct reflowData { // data to reflow lines
-        qint64 index;
-        LineProperty lineFlag;
+    struct IndexEntry {
+        CellPosition start;
+        qint32 count;
+        LineProperty property;
     };
+
+    enum Streams { IndexStream = 0, CellsStream = 1, StreamCount };
+
+    IndexEntry indexEntry(const int lineno) const;
+    const char *chunk(qint64 loc, int *cellCount, qsizetype *size) const;
+    CellPosition advance(CellPosition position, int count) const;
+
+    HistoryFile _file;
+
+    // Start and length of the line being added
+    qint64 _pendingStart = 0;
+    int _pendingCount = 0;
+
+    // Holds the cells of addCells() while they are encoded, and chunks which
+    // are split between two segments of the file
+    mutable QByteArray _scratch;
 };
 
 }
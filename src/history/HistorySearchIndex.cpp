@@ -0,0 +1,212 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Own
+#include "HistorySearchIndex.h"
+
+// Qt
+#include <QtAlgorithms>
+
+// STD
+#include <algorithm>
+
+using namespace Konsole;
+
+static inline char32_t foldCase(char32_t c)
+{
+    if (c < 0x80) {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+    return QChar::toCaseFolded(c);
+}
+
+HistorySearchIndex::HistorySearchIndex() = default;
+
+void HistorySearchIndex::invalidate()
+{
+    _valid = false;
+    _blocks = {};
+}
+
+void HistorySearchIndex::clear()
+{
+    _blocks = {};
+    _firstLine = 0;
+    _endLine = 0;
+    _logicalLine = 0;
+    _lastLineWrapped = false;
+    _tailLength = 0;
+    _valid = true;
+}
+
+uint HistorySearchIndex::trigramHash(char32_t a, char32_t b, char32_t c)
+{
+    uint h = (a * 0x9E3779B1u) ^ (b * 0x85EBCA77u) ^ (c * 0xC2B2AE3Du);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+void HistorySearchIndex::foldSignature(Block &block)
+{
+    // Bit i of a signature of n bits is set for the hashes which are i modulo
+    // n, so or-ing its halves gives the signature of n / 2 bits
+    std::vector<quint64> &signature = block.signature;
+    while (signature.size() > 1) {
+        const size_t half = signature.size() / 2;
+        uint bits = 0;
+        for (size_t i = 0; i < half; ++i) {
+            bits += qPopulationCount(signature[i] | signature[half + i]);
+        }
+        // Stop before a fifth of the bits would be set, as in a complete block
+        if (bits * 5 > half * 64) {
+            break;
+        }
+        for (size_t i = 0; i < half; ++i) {
+            signature[i] |= signature[half + i];
+        }
+        signature.resize(half);
+    }
+    signature.shrink_to_fit();
+}
+
+void HistorySearchIndex::addCodePoint(char32_t c)
+{
+    c = foldCase(c);
+    if (_tailLength == 2) {
+        Block &block = _blocks.back();
+        const uint hash = trigramHash(_tail[0], _tail[1], c) & (block.signature.size() * 64 - 1);
+        block.signature[hash / 64] |= quint64(1) << (hash % 64);
+        ++block.trigrams;
+        _tail[0] = _tail[1];
+        _tail[1] = c;
+    } else {
+        _tail[_tailLength++] = c;
+    }
+}
+
+void HistorySearchIndex::addLine(const Character *cells, int count, LineProperty property)
+{
+    if (!_valid) {
+        return;
+    }
+
+    const qint64 line = _endLine++;
+
+    // Blocks start with logical lines, or with the rest of a logical line
+    // whose start was removed, see removeFirstLines()
+    bool newBlock = _blocks.empty();
+    if (!_lastLineWrapped) {
+        _logicalLine = line;
+        _tailLength = 0;
+        if (!newBlock && (line - _blocks.back().firstLine >= BlockLines || _blocks.back().trigrams >= BlockTrigrams)) {
+            foldSignature(_blocks.back());
+            newBlock = true;
+        }
+    }
+    if (newBlock) {
+        _blocks.push_back({std::vector<quint64>(SignatureBits / 64), line, line, 0});
+    }
+
+    // Index the same text as Screen::copyLineToStream() and
+    // PlainTextDecoder::decodeLine() write, which is the text that is searched
+    while (count > 0 && (cells[count - 1].flags & EF_REAL) == 0) {
+        count--;
+    }
+    for (int i = 0; i < count;) {
+        const Character &cell = cells[i];
+        if (cell.character < 0x80 && cell.rendition.f.extended == 0) {
+            if (!cell.isRightHalfOfDoubleWide()) {
+                addCodePoint(cell.character);
+            }
+            ++i;
+        } else if (cell.rendition.f.extended != 0) {
+            ushort extendedCharLength = 0;
+            const char32_t *chars = ExtendedCharTable::instance.lookupExtendedChar(cell.character, extendedCharLength);
+            if (chars != nullptr) {
+                for (uint n = 0; n < extendedCharLength; ++n) {
+                    addCodePoint(chars[n]);
+                }
+                i += qMax(1, Character::stringWidth(chars, extendedCharLength));
+            } else {
+                ++i;
+            }
+        } else {
+            addCodePoint(cell.character);
+            i += qMax(1, Character::stringWidth(&cell.character, 1));
+        }
+    }
+
+    _blocks.back().lastLine = line;
+    _lastLineWrapped = property.flags.f.wrapped != 0;
+}
+
+void HistorySearchIndex::removeFirstLines(int count)
+{
+    if (!_valid) {
+        return;
+    }
+
+    _firstLine += std::min<qint64>(count, lineCount());
+
+    // The signature of a block whose first lines were removed still holds
+    // the trigrams of the rest of them
+    while (!_blocks.empty() && _blocks.front().lastLine < _firstLine) {
+        _blocks.pop_front();
+    }
+}
+
+QList<QPair<int, int>> HistorySearchIndex::candidateLines(const QString &text) const
+{
+    std::vector<uint> hashes;
+    char32_t window[2] = {0, 0};
+    int windowLength = 0;
+    const QList<uint> codePoints = text.toUcs4();
+    for (const uint codePoint : codePoints) {
+        if (codePoint == '\n' || codePoint == '\r') {
+            windowLength = 0;
+            continue;
+        }
+        const char32_t c = foldCase(codePoint);
+        if (windowLength == 2) {
+            hashes.push_back(trigramHash(window[0], window[1], c));
+            window[0] = window[1];
+            window[1] = c;
+        } else {
+            window[windowLength++] = c;
+        }
+    }
+
+    QList<QPair<int, int>> result;
+    for (const Block &block : _blocks) {
+        const uint mask = block.signature.size() * 64 - 1;
+        const bool candidate = std::all_of(hashes.cbegin(), hashes.cend(), [&block, mask](uint hash) {
+            hash &= mask;
+            return (block.signature[hash / 64] & (quint64(1) << (hash % 64))) != 0;
+        });
+        if (!candidate) {
+            continue;
+        }
+
+        const int first = std::max(block.firstLine, _firstLine) - _firstLine;
+        const int last = block.lastLine - _firstLine;
+        if (!result.isEmpty() && first <= result.last().second + 1) {
+            result.last().second = std::max(result.last().second, last);
+        } else {
+            result.append({first, last});
+        }
+    }
+    return result;
+}
+
+int HistorySearchIndex::openLineStart() const
+{
+    if (!_lastLineWrapped) {
+        return lineCount();
+    }
+    return std::max(_logicalLine, _firstLine) - _firstLine;
+}
@@ -0,0 +1,135 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef HISTORYSEARCHINDEX_H
+#define HISTORYSEARCHINDEX_H
+
+#include "characters/Character.h"
+#include "konsoleprivate_export.h"
+
+// Qt
+#include <QList>
+#include <QPair>
+#include <QString>
+
+// STD
+#include <deque>
+#include <vector>
+
+namespace Konsole
+{
+/**
+ * An index of the text of the history lines of a screen, used to find the
+ * lines which may contain a given string without decoding the whole history.
+ *
+ * The lines are grouped in blocks of up to BlockLines lines.  For each block,
+ * the index keeps a signature: a bit set of the hashes of the trigrams
+ * (sequences of three case folded code points) of the text of the logical
+ * lines which start in the block.  A logical line is a line together with the
+ * lines it wraps into, so a string which does not contain a line break always
+ * has all its trigrams in the signature of a single block.
+ *
+ * A block ends early once it has BlockTrigrams trigrams, so that the
+ * signatures of wide lines full of text don't have almost all bits set, and
+ * the signature of a complete block is folded to the fewest bits which keep it
+ * sparse, so that blocks of short lines don't take more memory than needed.
+ *
+ * Lines are added at the end and removed from the start, as the history does,
+ * so the index can be kept up to date as lines are added to the history.
+ */
+class KONSOLEPRIVATE_EXPORT HistorySearchIndex
+{
+public:
+    /** Number of lines in a block, at most */
+    static constexpr int BlockLines = 32;
+
+    HistorySearchIndex();
+
+    /**
+     * Returns true if the index holds the lines of the history.  An invalid
+     * index ignores added and removed lines until it is cleared.
+     */
+    bool isValid() const
+    {
+        return _valid;
+    }
+
+    /** Marks the index as invalid, after the history was changed other than by adding or removing lines */
+    void invalidate();
+
+    /** Removes all lines and marks the index as valid */
+    void clear();
+
+    /** Returns the number of lines in the index */
+    int lineCount() const
+    {
+        return _endLine - _firstLine;
+    }
+
+    /** Adds a line at the end of the index */
+    void addLine(const Character *cells, int count, LineProperty property);
+
+    /** Removes the first @p count lines */
+    void removeFirstLines(int count);
+
+    /**
+     * Returns the ranges of lines, as pairs of first and last line, which may
+     * contain @p text.  Lines which do not appear in any of the ranges don't
+     * contain @p text, ignoring case.
+     *
+     * A range may end with a wrapped line, in which case the text may continue
+     * after the end of the index; see openLineStart().
+     */
+    QList<QPair<int, int>> candidateLines(const QString &text) const;
+
+    /**
+     * Returns the first line of the logical line which the last line of the
+     * index wraps into, or lineCount() if the last line is not wrapped.
+     */
+    int openLineStart() const;
+
+private:
+    // Number of bits of the signature of the block being added to
+    static constexpr int SignatureBits = 4096;
+    // Number of trigrams after which a block ends, which sets about a fifth of the signature bits
+    static constexpr int BlockTrigrams = SignatureBits / 4;
+
+    struct Block {
+        // A power of two number of bits
+        std::vector<quint64> signature;
+        qint64 firstLine = 0;
+        // Last line of the logical lines which start in the block
+        qint64 lastLine = 0;
+        int trigrams = 0;
+    };
+
+    static uint trigramHash(char32_t a, char32_t b, char32_t c);
+    static void foldSignature(Block &block);
+    void addCodePoint(char32_t c);
+
+    // The logical line being added to is in the last block
+    std::deque<Block> _blocks;
+
+    // Lines are numbered since the index was cleared, _firstLine is the
+    // first line which was not removed, and _endLine the next line to add
+    qint64 _firstLine = 0;
+    qint64 _endLine = 0;
+
+    // First line of the logical line being added to, if the last line added
+    // was wrapped
+    qint64 _logicalLine = 0;
+    bool _lastLineWrapped = false;
+
+    // Last two code points of the logical line being added to
+    char32_t _tail[2] = {0, 0};
+    int _tailLength = 0;
+
+    bool _valid = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,458 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Own
+#include "CellBlockStore.h"
+
+// Qt
+#include <QtEndian>
+
+// STD
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+
+using namespace Konsole;
+
+// Number of blocks at the end of the store which are kept uncompressed, so
+// that lines which have just been added to the history are cheap to read
+static const size_t HOT_BLOCKS = 2;
+
+// Compression level passed to qCompress(), favoring speed over size
+static const int COMPRESSION_LEVEL = 1;
+
+CellBlockStore::CellBlockStore() = default;
+
+CellBlockStore::~CellBlockStore() = default;
+
+void CellBlockStore::append(const Character *cells, size_t count)
+{
+    while (count > 0) {
+        if (_blocks.empty() || _blocks.back().size == BlockSize) {
+            _blocks.emplace_back();
+            _blocks.back().codePoints.reserve(BlockSize);
+            if (_blocks.size() > HOT_BLOCKS) {
+                compress(_blocks[_blocks.size() - 1 - HOT_BLOCKS]);
+            }
+        }
+
+        Block &block = _blocks.back();
+        const int n = static_cast<int>(std::min<size_t>(count, BlockSize - block.size));
+        appendToBlock(block, cells, n);
+
+        cells += n;
+        count -= n;
+        _size += n;
+    }
+}
+
+void CellBlockStore::read(size_t index, size_t count, Character *buffer) const
+{
+    Q_ASSERT(index + count <= _size);
+
+    size_t position = index + _frontOffset;
+    while (count > 0) {
+        const size_t blockIndex = position / BlockSize;
+        const int offset = static_cast<int>(position % BlockSize);
+        const int n = static_cast<int>(std::min<size_t>(count, BlockSize - offset));
+
+        readBlock(hotBlock(blockIndex), offset, n, buffer);
+
+        buffer += n;
+        position += n;
+        count -= n;
+    }
+}
+
+void CellBlockStore::removeFront(size_t count)
+{
+    if (count >= _size) {
+        clear();
+        return;
+    }
+
+    _size -= count;
+    _frontOffset += count;
+    while (_frontOffset >= BlockSize) {
+        _blocks.pop_front();
+        _frontOffset -= BlockSize;
+        ++_firstBlockNumber;
+    }
+}
+
+void CellBlockStore::truncate(size_t count)
+{
+    if (count >= _size) {
+        return;
+    }
+    if (count == 0) {
+        clear();
+        return;
+    }
+
+    const size_t end = count + _frontOffset;
+    const size_t lastBlock = (end - 1) / BlockSize;
+    _blocks.resize(lastBlock + 1);
+
+    // Block numbers after the new last block will be used again by new blocks
+    for (CacheEntry &entry : _cache) {
+        if (entry.blockNumber != size_t(-1) && entry.blockNumber >= _firstBlockNumber + lastBlock) {
+            entry.blockNumber = size_t(-1);
+        }
+    }
+
+    Block &block = _blocks.back();
+    if (!block.compressed.isEmpty()) {
+        Block plain;
+        uncompress(block, plain);
+        block = std::move(plain);
+    }
+
+    const int newSize = static_cast<int>(end - lastBlock * BlockSize);
+    block.size = newSize;
+    block.codePoints.truncate(newSize * block.codePointSize);
+    while (block.runs.back().start >= newSize) {
+        block.runs.pop_back();
+    }
+
+    _size = count;
+}
+
+void CellBlockStore::clear()
+{
+    _firstBlockNumber += _blocks.size();
+    _blocks.clear();
+    _frontOffset = 0;
+    _size = 0;
+}
+
+size_t CellBlockStore::memoryUsage() const
+{
+    size_t bytes = _blocks.size() * sizeof(Block);
+    for (const Block &block : _blocks) {
+        bytes += block.runs.capacity() * sizeof(AttributeRun);
+        bytes += block.codePoints.capacity();
+        bytes += block.compressed.capacity();
+    }
+    return bytes;
+}
+
+// Returns the number of bytes needed to store each code point of @p cells,
+// which is at least @p minimum
+static quint8 codePointSizeFor(const Character *cells, int count, quint8 minimum)
+{
+    quint8 codePointSize = minimum;
+    for (int i = 0; i < count; ++i) {
+        const char32_t c = cells[i].character;
+        if (c > 0xFFFF) {
+            return 4;
+        }
+        if (c > 0xFF && codePointSize < 2) {
+            codePointSize = 2;
+        }
+    }
+    return codePointSize;
+}
+
+static void writeCodePoints(char *out, const Character *cells, int count, quint8 codePointSize)
+{
+    switch (codePointSize) {
+    case 1:
+        for (int i = 0; i < count; ++i) {
+            out[i] = static_cast<char>(cells[i].character);
+        }
+        break;
+    case 2:
+        for (int i = 0; i < count; ++i) {
+            const quint16 c = cells[i].character;
+            memcpy(out + i * 2, &c, 2);
+        }
+        break;
+    default:
+        for (int i = 0; i < count; ++i) {
+            const quint32 c = cells[i].character;
+            memcpy(out + i * 4, &c, 4);
+        }
+        break;
+    }
+}
+
+void CellBlockStore::appendToBlock(Block &block, const Character *cells, int count)
+{
+    const quint8 codePointSize = codePointSizeFor(cells, count, block.codePointSize);
+    if (codePointSize > block.codePointSize) {
+        widenCodePoints(block, codePointSize);
+    }
+
+    const qsizetype oldBytes = block.codePoints.size();
+    block.codePoints.resize(oldBytes + count * codePointSize);
+    writeCodePoints(block.codePoints.data() + oldBytes, cells, count, codePointSize);
+
+    for (int i = 0; i < count; ++i) {
+        const Character &c = cells[i];
+        if (block.runs.empty() || !block.runs.back().sameAttributes(c)) {
+            block.runs.push_back({static_cast<quint16>(block.size + i), c.rendition, c.flags, c.foregroundColor, c.backgroundColor});
+        }
+    }
+
+    block.size += count;
+}
+
+void CellBlockStore::widenCodePoints(Block &block, quint8 codePointSize)
+{
+    QByteArray widened(qsizetype(BlockSize) * codePointSize, Qt::Uninitialized);
+    widened.resize(qsizetype(block.size) * codePointSize);
+
+    const char *in = block.codePoints.constData();
+    char *out = widened.data();
+    for (int i = 0; i < block.size; ++i) {
+        quint32 c = 0;
+        if (block.codePointSize == 1) {
+            c = static_cast<uchar>(in[i]);
+        } else {
+            quint16 c16;
+            memcpy(&c16, in + i * 2, 2);
+            c = c16;
+        }
+
+        if (codePointSize == 2) {
+            const quint16 c16 = c;
+            memcpy(out + i * 2, &c16, 2);
+        } else {
+            memcpy(out + i * 4, &c, 4);
+        }
+    }
+
+    block.codePoints = std::move(widened);
+    block.codePointSize = codePointSize;
+}
+
+void CellBlockStore::readBlock(const Block &block, int offset, int count, Character *buffer)
+{
+    Q_ASSERT(offset + count <= block.size);
+    readCells(reinterpret_cast<const char *>(block.runs.data()), block.runs.size(), block.codePoints.constData(), block.codePointSize, offset, count, buffer);
+}
+
+void CellBlockStore::readCells(const char *runs, int runCount, const char *codePoints, quint8 codePointSize, int offset, int count, Character *buffer)
+{
+    const char *in = codePoints + offset * codePointSize;
+    switch (codePointSize) {
+    case 1:
+        for (int i = 0; i < count; ++i) {
+            buffer[i].character = static_cast<uchar>(in[i]);
+        }
+        break;
+    case 2:
+        for (int i = 0; i < count; ++i) {
+            quint16 c;
+            memcpy(&c, in + i * 2, 2);
+            buffer[i].character = c;
+        }
+        break;
+    default:
+        for (int i = 0; i < count; ++i) {
+            quint32 c;
+            memcpy(&c, in + i * 4, 4);
+            buffer[i].character = c;
+        }
+        break;
+    }
+
+    // The runs may not be aligned when they are read from a file, so copy
+    // them out instead of accessing them in place
+    auto runStart = [runs](int index) {
+        quint16 start;
+        memcpy(&start, runs + index * sizeof(AttributeRun) + offsetof(AttributeRun, start), sizeof(start));
+        return int(start);
+    };
+
+    // Find the run containing the first cell, then walk the following ones
+    int first = 0;
+    int last = runCount - 1;
+    while (first < last) {
+        const int middle = (first + last + 1) / 2;
+        if (runStart(middle) <= offset) {
+            first = middle;
+        } else {
+            last = middle - 1;
+        }
+    }
+
+    int runIndex = first;
+    AttributeRun run;
+    memcpy(&run, runs + runIndex * sizeof(AttributeRun), sizeof(AttributeRun));
+    int nextStart = runIndex + 1 < runCount ? runStart(runIndex + 1) : BlockSize;
+
+    for (int i = 0; i < count; ++i) {
+        const int position = offset + i;
+        while (position >= nextStart) {
+            ++runIndex;
+            memcpy(&run, runs + runIndex * sizeof(AttributeRun), sizeof(AttributeRun));
+            nextStart = runIndex + 1 < runCount ? runStart(runIndex + 1) : BlockSize;
+        }
+        Character &c = buffer[i];
+        c.rendition = run.rendition;
+        c.flags = run.flags;
+        c.foregroundColor = run.foregroundColor;
+        c.backgroundColor = run.backgroundColor;
+    }
+}
+
+const CellBlockStore::Block &CellBlockStore::hotBlock(size_t blockIndex) const
+{
+    const Block &block = _blocks[blockIndex];
+    if (block.compressed.isEmpty()) {
+        return block;
+    }
+
+    const size_t blockNumber = _firstBlockNumber + blockIndex;
+    for (const CacheEntry &entry : _cache) {
+        if (entry.blockNumber == blockNumber) {
+            return entry.block;
+        }
+    }
+
+    CacheEntry &entry = _cache[_cacheNext];
+    _cacheNext = (_cacheNext + 1) % int(std::size(_cache));
+    uncompress(block, entry.block);
+    entry.blockNumber = blockNumber;
+    return entry.block;
+}
+
+void CellBlockStore::compress(Block &block)
+{
+    if (!block.compressed.isEmpty()) {
+        return;
+    }
+
+    const QByteArray data = serialize(block);
+    QByteArray compressed = qCompress(data, COMPRESSION_LEVEL);
+    if (compressed.size() >= data.size()) {
+        // Not worth it, but release the space reserved for appending
+        block.codePoints.squeeze();
+        block.runs.shrink_to_fit();
+        return;
+    }
+
+    block.compressed = std::move(compressed);
+    block.codePoints = QByteArray();
+    block.runs = std::vector<AttributeRun>();
+}
+
+void CellBlockStore::uncompress(const Block &block, Block &result)
+{
+    const QByteArray data = qUncompress(block.compressed);
+    const bool ok = deserialize(data.constData(), data.size(), result);
+    Q_ASSERT(ok);
+    Q_UNUSED(ok)
+}
+
+void CellBlockStore::writeHeader(char *out, const SerializedHeader &header)
+{
+    qToLittleEndian(header.size, out);
+    qToLittleEndian(header.runCount, out + 2);
+    out[4] = char(header.codePointSize);
+    // reserved
+    out[5] = 0;
+}
+
+CellBlockStore::SerializedHeader CellBlockStore::readHeader(const char *data)
+{
+    return {qFromLittleEndian<quint16>(data), qFromLittleEndian<quint16>(data + 2), quint8(data[4])};
+}
+
+QByteArray CellBlockStore::serialize(const Block &block)
+{
+    const SerializedHeader header = {block.size, static_cast<quint16>(block.runs.size()), block.codePointSize};
+    const qsizetype runBytes = block.runs.size() * sizeof(AttributeRun);
+
+    QByteArray data(EncodedHeaderSize + runBytes + block.codePoints.size(), Qt::Uninitialized);
+    char *out = data.data();
+    writeHeader(out, header);
+    memcpy(out + EncodedHeaderSize, block.runs.data(), runBytes);
+    memcpy(out + EncodedHeaderSize + runBytes, block.codePoints.constData(), block.codePoints.size());
+    return data;
+}
+
+bool CellBlockStore::deserialize(const char *data, qsizetype size, Block &block)
+{
+    if (size < EncodedHeaderSize) {
+        return false;
+    }
+    const SerializedHeader header = readHeader(data);
+
+    if (header.size > BlockSize || (header.codePointSize != 1 && header.codePointSize != 2 && header.codePointSize != 4)
+        || (header.size > 0 && header.runCount == 0)) {
+        return false;
+    }
+    const qsizetype runBytes = header.runCount * sizeof(AttributeRun);
+    const qsizetype codePointBytes = qsizetype(header.size) * header.codePointSize;
+    if (size != EncodedHeaderSize + runBytes + codePointBytes) {
+        return false;
+    }
+
+    block.size = header.size;
+    block.codePointSize = header.codePointSize;
+    block.runs.resize(header.runCount);
+    memcpy(block.runs.data(), data + EncodedHeaderSize, runBytes);
+    block.codePoints = QByteArray(data + EncodedHeaderSize + runBytes, codePointBytes);
+    block.compressed.clear();
+    return true;
+}
+
+void CellBlockStore::encode(const Character *cells, int count, QByteArray &out)
+{
+    do {
+        const int n = std::min(count, BlockSize);
+        const quint8 codePointSize = codePointSizeFor(cells, n, 1);
+
+        int runCount = 0;
+        for (int i = 0; i < n; ++i) {
+            if (i == 0 || !cells[i].equalsFormat(cells[i - 1]) || cells[i].flags != cells[i - 1].flags) {
+                ++runCount;
+            }
+        }
+
+        const SerializedHeader header = {static_cast<quint16>(n), static_cast<quint16>(runCount), codePointSize};
+        const qsizetype start = out.size();
+        out.resize(start + EncodedHeaderSize + runCount * sizeof(AttributeRun) + n * codePointSize);
+
+        char *data = out.data() + start;
+        writeHeader(data, header);
+        data += EncodedHeaderSize;
+        for (int i = 0; i < n; ++i) {
+            const Character &c = cells[i];
+            if (i == 0 || !c.equalsFormat(cells[i - 1]) || c.flags != cells[i - 1].flags) {
+                const AttributeRun run = {static_cast<quint16>(i), c.rendition, c.flags, c.foregroundColor, c.backgroundColor};
+                memcpy(data, &run, sizeof(run));
+                data += sizeof(run);
+            }
+        }
+        writeCodePoints(data, cells, n, codePointSize);
+
+        cells += n;
+        count -= n;
+    } while (count > 0);
+}
+
+qsizetype CellBlockStore::encodedChunkSize(const char *header, int *cellCount)
+{
+    const SerializedHeader h = readHeader(header);
+    if (cellCount) {
+        *cellCount = h.size;
+    }
+    return EncodedHeaderSize + h.runCount * sizeof(AttributeRun) + qsizetype(h.size) * h.codePointSize;
+}
+
+void CellBlockStore::decode(const char *chunk, int offset, int count, Character *buffer)
+{
+    const SerializedHeader header = readHeader(chunk);
+    Q_ASSERT(offset + count <= header.size);
+
+    const char *runs = chunk + EncodedHeaderSize;
+    readCells(runs, header.runCount, runs + header.runCount * sizeof(AttributeRun), header.codePointSize, offset, count, buffer);
+}
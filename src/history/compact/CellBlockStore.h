@@ -0,0 +1,158 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef CELLBLOCKSTORE_H
+#define CELLBLOCKSTORE_H
+
+#include "characters/Character.h"
+#include "konsoleprivate_export.h"
+
+// Qt
+#include <QByteArray>
+
+// STD
+#include <deque>
+#include <vector>
+
+namespace Konsole
+{
+/**
+ * A sequence of Characters stored in fixed-size blocks with a compact encoding.
+ *
+ * Instead of keeping 16 bytes per cell, each block stores the code points
+ * packed to the smallest width (1, 2 or 4 bytes) that holds all of them, and
+ * the colors, rendition and flags as runs that cover consecutive cells with
+ * the same attributes.  Blocks which are no longer written to are compressed
+ * with qCompress() and decompressed into a small cache when read.
+ *
+ * Cells are appended at the end, and can be removed from either end.  They are
+ * addressed by their position relative to the first cell in the store.
+ */
+class KONSOLEPRIVATE_EXPORT CellBlockStore
+{
+public:
+    /** Number of cells in a block */
+    static constexpr int BlockSize = 4096;
+
+    CellBlockStore();
+    ~CellBlockStore();
+
+    /** Returns the number of cells in the store */
+    size_t size() const
+    {
+        return _size;
+    }
+
+    /** Appends @p count cells from @p cells at the end of the store */
+    void append(const Character *cells, size_t count);
+
+    /** Copies @p count cells starting at @p index into @p buffer */
+    void read(size_t index, size_t count, Character *buffer) const;
+
+    /** Removes the first @p count cells */
+    void removeFront(size_t count);
+
+    /** Removes all cells from position @p count onwards */
+    void truncate(size_t count);
+
+    /** Removes all cells */
+    void clear();
+
+    /** Returns the approximate number of bytes used to store the cells */
+    size_t memoryUsage() const;
+
+    /**
+     * Appends @p count cells to @p out, in the uncompressed encoding used for
+     * blocks.  The cells are written as a sequence of chunks of at most
+     * BlockSize cells each; at least one chunk is written, even if @p count is 0.
+     */
+    static void encode(const Character *cells, int count, QByteArray &out);
+
+    /** Size of the header at the start of each chunk written by encode() */
+    static constexpr int EncodedHeaderSize = 6;
+
+    /**
+     * Returns the size in bytes of the chunk which starts with @p header,
+     * and stores the number of cells in it in @p cellCount if not null.
+     */
+    static qsizetype encodedChunkSize(const char *header, int *cellCount = nullptr);
+
+    /** Decodes @p count cells starting at @p offset from the chunk at @p chunk */
+    static void decode(const char *chunk, int offset, int count, Character *buffer);
+
+private:
+    Q_DISABLE_COPY(CellBlockStore)
+
+    // Written field by field, see writeHeader(), so that no padding or
+    // uninitialized byte ends up in the encoded data
+    struct SerializedHeader {
+        quint16 size;
+        quint16 runCount;
+        quint8 codePointSize;
+    };
+    static void writeHeader(char *out, const SerializedHeader &header);
+    static SerializedHeader readHeader(const char *data);
+
+    /** Attributes of consecutive cells of a block, starting at cell @c start */
+    struct AttributeRun {
+        quint16 start;
+        RenditionFlagsC rendition;
+        ExtraFlags flags;
+        CharacterColor foregroundColor;
+        CharacterColor backgroundColor;
+
+        bool sameAttributes(const Character &c) const
+        {
+            return rendition.all == c.rendition.all && flags == c.flags && foregroundColor == c.foregroundColor && backgroundColor == c.backgroundColor;
+        }
+    };
+
+    struct Block {
+        // Sorted by start, the first run always starts at cell 0
+        std::vector<AttributeRun> runs;
+        // Code points of the cells, codePointSize bytes each
+        QByteArray codePoints;
+        quint8 codePointSize = 1;
+        quint16 size = 0;
+        // If not empty the block is cold, and this holds the compressed runs
+        // and code points, which are then empty
+        QByteArray compressed;
+    };
+
+    /** Returns @p blockIndex, or an uncompressed copy of it if it is cold */
+    const Block &hotBlock(size_t blockIndex) const;
+
+    static void appendToBlock(Block &block, const Character *cells, int count);
+    static void widenCodePoints(Block &block, quint8 codePointSize);
+    static void readBlock(const Block &block, int offset, int count, Character *buffer);
+    static void readCells(const char *runs, int runCount, const char *codePoints, quint8 codePointSize, int offset, int count, Character *buffer);
+    static void compress(Block &block);
+    static void uncompress(const Block &block, Block &result);
+
+    static QByteArray serialize(const Block &block);
+    static bool deserialize(const char *data, qsizetype size, Block &block);
+
+    std::deque<Block> _blocks;
+
+    // Number of the first block since the store was created, used to identify
+    // blocks in the cache
+    size_t _firstBlockNumber = 0;
+    // Position of the first cell in the first block
+    size_t _frontOffset = 0;
+    size_t _size = 0;
+
+    // Most recently read cold blocks, uncompressed
+    struct CacheEntry {
+        size_t blockNumber = size_t(-1);
+        Block block;
+    };
+    mutable CacheEntry _cache[2];
+    mutable int _cacheNext = 0;
+};
+
+}
+
+#endif
@@ -24,7 +24,7 @@ void CompactHistoryScroll::removeLinesFromTop(size_t lines)
         const unsigned int removing = _lineDatas.at(lines - 1).index;
         _lineDatas.erase(_lineDatas.begin(), _lineDatas.begin() + lines);
 
-        _cells.erase(_cells.begin(), _cells.begin() + (removing - _indexBias));
+        _cells.removeFront(removing - _indexBias);
         _indexBias = removing;
     } else {
         _lineDatas.clear();
@@ -34,7 +34,7 @@ void CompactHistoryScroll::removeLinesFromTop(size_t lines)
 
 void CompactHistoryScroll::addCells(const Character a[], const int count)
 {
-    _cells.insert(_cells.end(), a, a + count);
+    _cells.append(a, count);
 
     // store the (biased) start of next line + default flag
     // the flag is later updated when addLine is called
@@ -47,15 +47,8 @@ void CompactHistoryScroll::addCells(const Character a[], const int count)
 
 void CompactHistoryScroll::addCellsMove(Character characters[], const int count)
 {
-    std::move(characters, characters + count, std::back_inserter(_cells));
-
-    // store the (biased) start of next line + default flag
-    // the flag is later updated when addLine is called
-    _lineDatas.push_back({static_cast<unsigned int>(_cells.size() + _indexBias), LineProperty()});
-
-    if (_lineDatas.size() > _maxLineCount + 1) {
-        removeLinesFromTop(1);
-    }
+    // cells are re-encoded when stored, so there is nothing to gain from moving
+    addCells(characters, count);
 }
 
 void CompactHistoryScroll::addLine(const LineProperty lineProperty)
@@ -93,9 +86,7 @@ void CompactHistoryScroll::getCells(const int lineNumber, const int startColumn,
     Q_ASSERT(startColumn >= 0);
     Q_ASSERT(startColumn <= lineLen(lineNumber) - count);
 
-    auto startCopy = _cells.begin() + startOfLine(lineNumber) + startColumn;
-    auto endCopy = startCopy + count;
-    std::copy(startCopy, endCopy, buffer);
+    _cells.read(startOfLine(lineNumber) + startColumn, count, buffer);
 }
 
 void CompactHistoryScroll::setMaxNbLines(const int lineCount)
@@ -121,7 +112,7 @@ void CompactHistoryScroll::removeCells()
         _lineDatas.pop_back();
 
         // remove the actual line content
-        _cells.erase(_cells.begin() + lastLineStart, _cells.end());
+        _cells.truncate(lastLineStart);
     } else {
         _cells.clear();
         _lineDatas.clear();
@@ -8,9 +8,9 @@
 #ifndef COMPACTHISTORYSCROLL_H
 #define COMPACTHISTORYSCROLL_H
 
+#include "CellBlockStore.h"
 #include "history/HistoryScroll.h"
 #include "konsoleprivate_export.h"
-#include <deque>
 
 namespace Konsole
 {
@@ -42,9 +42,10 @@ public:
 
 private:
     /**
-     * This is the actual buffer that contains the cells
+     * This is the actual buffer that contains the cells, see CellBlockStore
+     * for how they are encoded
      */
-    std::deque<Character> _cells;
+    CellBlockStore _cells;
 
     /**
      * Each entry contains the start of the next line and the current line's
@@ -59,8 +60,7 @@ private:
      * unsigned int means we're limited in common architectures to 4 million
      * characters, but CompactHistoryScroll is limited by the UI to 1_000_000
      * lines (see historyLineSpinner in src/widgets/HistorySizeWidget.ui), so
-     * enough for 1_000_000 lines of an average ~4295 length (and each
-     * Character takes 16 bytes, so that's 64Gb!).
+     * enough for 1_000_000 lines of an average ~4295 length.
      */
     struct LineData {
         unsigned int index;
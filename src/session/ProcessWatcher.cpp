@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+// Own
+#include "ProcessWatcher.h"
+
+// Konsole
+#include "Session.h"
+
+#include <utility>
+
+// Interval between the passes which update the sessions, in ms
+static const int UPDATE_INTERVAL = 2000;
+
+using namespace Konsole;
+
+Q_GLOBAL_STATIC(ProcessWatcher, theProcessWatcher)
+
+ProcessWatcher::ProcessWatcher()
+{
+    _timer.setSingleShot(true);
+    _timer.setInterval(UPDATE_INTERVAL);
+    connect(&_timer, &QTimer::timeout, this, &Konsole::ProcessWatcher::updateSessions);
+}
+
+ProcessWatcher::~ProcessWatcher() = default;
+
+ProcessWatcher *ProcessWatcher::instance()
+{
+    return theProcessWatcher;
+}
+
+void ProcessWatcher::requestUpdate(Session *session)
+{
+    if (!_pendingSessions.contains(session)) {
+        _pendingSessions.append(session);
+    }
+    if (!_timer.isActive()) {
+        _timer.start();
+    }
+}
+
+void ProcessWatcher::updateSessions()
+{
+    // The sessions which request an update while they are updated are
+    // updated in the next pass
+    const QList<QPointer<Session>> sessions = std::exchange(_pendingSessions, {});
+    for (const QPointer<Session> &session : sessions) {
+        if (!session.isNull()) {
+            session->updateProcessInfo();
+        }
+    }
+}
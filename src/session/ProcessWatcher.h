@@ -0,0 +1,62 @@
+/*
+    SPDX-FileCopyrightText: 2026 Konsole Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef PROCESSWATCHER_H
+#define PROCESSWATCHER_H
+
+// Qt
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+// Konsole
+#include "konsoleprivate_export.h"
+
+namespace Konsole
+{
+class Session;
+
+/**
+ * Updates the information about the processes running in the sessions,
+ * which the tab titles, the current directories and the container contexts
+ * are based on, a while after the user interacted with the sessions or
+ * they showed output.
+ *
+ * Instead of each session polling /proc on its own timer, the sessions
+ * which requested an update are updated together in one pass, so that
+ * many busy sessions read /proc at most once per pass each and the GUI
+ * thread is interrupted once per interval rather than once per session.
+ * See Session::updateProcessInfo().
+ */
+class KONSOLEPRIVATE_EXPORT ProcessWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProcessWatcher();
+    ~ProcessWatcher() override;
+
+    /** Returns the process watcher shared by all sessions. */
+    static ProcessWatcher *instance();
+
+    /**
+     * Updates the process information of @p session in the next pass,
+     * UPDATE_INTERVAL ms after the first request since the last pass at
+     * most.
+     */
+    void requestUpdate(Session *session);
+
+private:
+    void updateSessions();
+
+    QTimer _timer;
+    QList<QPointer<Session>> _pendingSessions;
+};
+
+}
+
+#endif // PROCESSWATCHER_H
@@ -181,6 +181,11 @@ void Session::openTeletype(int fd, bool runShell)
     }
 
     _shellProcess->setUtf8Mode(_emulation->utf8());
+#ifndef Q_OS_WIN
+    if (KonsoleSettings::readOutputInThread()) {
+        _shellProcess->startReaderThread();
+    }
+#endif
 
     // connect the I/O between emulator and pty process
     connect(_shellProcess, &Konsole::Pty::receivedData, this, &Konsole::Session::onReceiveBlock);
@@ -1233,6 +1238,22 @@ QString Session::title(TitleRole role) const
     }
 }
 
+void Session::updateProcessInfo()
+{
+    if (_shellProcess == nullptr) {
+        return;
+    }
+
+    _updatingProcessInfo = true;
+    getProcessInfo();
+    updateWorkingDirectory();
+    Q_EMIT processInfoUpdated();
+    _updatingProcessInfo = false;
+
+    _sessionProcessInfoUpdated = false;
+    _foregroundProcessInfoUpdated = false;
+}
+
 ProcessInfo *Session::getProcessInfo()
 {
     ProcessInfo *process = nullptr;
@@ -1275,8 +1296,11 @@ void Session::updateSessionProcessInfo()
 #endif
 
         _sessionProcessInfo->setUserHomeDir();
+    } else if (_sessionProcessInfoUpdated) {
+        return;
     }
     _sessionProcessInfo->update();
+    _sessionProcessInfoUpdated = _updatingProcessInfo;
 }
 
 bool Session::updateForegroundProcessInfo()
@@ -1292,10 +1316,13 @@ bool Session::updateForegroundProcessInfo()
         _foregroundProcessInfo = ProcessInfo::newInstance(foregroundPid, processId());
 #endif
         _foregroundPid = foregroundPid;
+    } else if (_foregroundProcessInfoUpdated) {
+        return _foregroundProcessInfo->isValid();
     }
 
     if (_foregroundProcessInfo != nullptr) {
         _foregroundProcessInfo->update();
+        _foregroundProcessInfoUpdated = _updatingProcessInfo;
 
         // Update container context detection when foreground process changes
         updateContainerContext();
@@ -1899,15 +1926,23 @@ void Session::updateContainerContext()
     _lastContainerCheckPid = _foregroundPid;
 
     // Detect container for current foreground process (polling-based, e.g., distrobox)
-    auto newContext = ContainerRegistry::instance()->detectContainer(_foregroundPid);
-    if (_enteredViaContainerCommand && _containerContext.isValid() && !newContext.isValid()) {
-        // Sessions started directly via "new tab in container" can briefly expose
-        // host-side foreground processes where polling detection returns empty.
-        // Keep the selected container context until we get explicit confirmation
-        // (valid detection or OSC 777), instead of dropping the badge prematurely.
-        return;
-    }
-    setContainerContext(newContext);
+    // The detection reads files of the process, so it runs in a worker thread
+    const int pid = _foregroundPid;
+    ContainerRegistry::instance()->detectContainerAsync(pid, this, [this, pid](const ContainerInfo &newContext) {
+        // Ignore the result if the foreground process changed or an OSC 777
+        // context was set in the meantime
+        if (pid != _lastContainerCheckPid || _containerContext.hostPid.has_value()) {
+            return;
+        }
+        if (_enteredViaContainerCommand && _containerContext.isValid() && !newContext.isValid()) {
+            // Sessions started directly via "new tab in container" can briefly expose
+            // host-side foreground processes where polling detection returns empty.
+            // Keep the selected container context until we get explicit confirmation
+            // (valid detection or OSC 777), instead of dropping the badge prematurely.
+            return;
+        }
+        setContainerContext(newContext);
+    });
 }
 
 void Session::setTitle(int role, const QString &title)
@@ -2145,6 +2180,11 @@ QStringList Session::getDisplayedTextList(int startLineOffset, int endLineOffset
     return list;
 }
 
+QString Session::renderStatistics() const
+{
+    return _emulation->renderStatistics()->toString();
+}
+
 int Session::foregroundProcessId()
 {
     int pid;
@@ -364,6 +364,15 @@ public:
     /** Returns a title generated from tab format and process information. */
     QString getDynamicTitle();
 
+    /**
+     * Reads the information about the foreground process and the current
+     * directory once, and emits processInfoUpdated(). The slots connected
+     * to it use that information instead of reading it again.
+     *
+     * This is called by the ProcessWatcher, see ProcessWatcher::requestUpdate().
+     */
+    void updateProcessInfo();
+
     /** Sets the name of the icon associated with this session. */
     void setIconName(const QString &iconName);
     /** Returns the name of the icon associated with this session. */
@@ -833,6 +842,13 @@ public Q_SLOTS:
      */
     Q_SCRIPTABLE QStringList getDisplayedTextList(int startLineOffset, int endLineOffset);
 
+    /**
+     * DBus slot for retrieving where the time spent showing the output of
+     * the session went, from parsing it to painting it, since the session
+     * started. See RenderStatistics.
+     */
+    Q_SCRIPTABLE QString renderStatistics() const;
+
     /**
      * DBus slot to get an XDG activation token.
      * Will check if the passed cookieForRequest is the m_activationCookie one for safety.
@@ -873,6 +889,9 @@ Q_SIGNALS:
      */
     void currentDirectoryChanged(const QString &dir);
 
+    /** Emitted by updateProcessInfo() when the process information was read. */
+    void processInfoUpdated();
+
     /**
      * Emitted when the container context of this session changes.
      * This occurs when the foreground process enters or exits a container.
@@ -1033,6 +1052,12 @@ private:
     Pty *_shellProcess = nullptr;
     Emulation *_emulation = nullptr;
 
+    // the process information is read once while updateProcessInfo() runs,
+    // see updateSessionProcessInfo() and updateForegroundProcessInfo()
+    bool _updatingProcessInfo = false;
+    bool _sessionProcessInfoUpdated = false;
+    bool _foregroundProcessInfoUpdated = false;
+
     QList<TerminalDisplay *> _views;
 
     // monitor activity & silence
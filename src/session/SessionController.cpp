@@ -80,6 +80,7 @@
 
 #include "profile/ProfileList.h"
 
+#include "ProcessWatcher.h"
 #include "SessionGroup.h"
 #include "SessionManager.h"
 
@@ -113,7 +114,6 @@ SessionController::SessionController(Session *sessionParam, TerminalDisplay *vie
     , _findAction(nullptr)
     , _findNextAction(nullptr)
     , _findPreviousAction(nullptr)
-    , _interactionTimer(nullptr)
     , _searchStartLine(0)
     , _prevSearchResultLine(0)
     , _codecAction(nullptr)
@@ -212,14 +212,8 @@ SessionController::SessionController(Session *sessionParam, TerminalDisplay *vie
     view()->setFlowControlWarningEnabled(session()->flowControlEnabled());
 
     // take a snapshot of the session state every so often when
-    // user activity occurs
-    //
-    // the timer is owned by the session so that it will be destroyed along
-    // with the session
-    _interactionTimer = new QTimer(session());
-    _interactionTimer->setSingleShot(true);
-    _interactionTimer->setInterval(2000);
-    connect(_interactionTimer, &QTimer::timeout, this, &Konsole::SessionController::snapshot);
+    // user activity occurs, see ProcessWatcher
+    connect(session(), &Konsole::Session::processInfoUpdated, this, &Konsole::SessionController::snapshot);
     connect(view(), &Konsole::TerminalDisplay::compositeFocusChanged, this, [this](bool focused) {
         if (focused) {
             interactionHandler();
@@ -327,9 +321,7 @@ void SessionController::viewFocusChangeHandler(bool focused)
 
 void SessionController::interactionHandler()
 {
-    if (!_interactionTimer->isActive()) {
-        _interactionTimer->start();
-    }
+    ProcessWatcher::instance()->requestUpdate(session());
 }
 
 void SessionController::snapshot()
@@ -1712,6 +1704,11 @@ void SessionController::beginSearch(const QString &text, Enum::SearchDirection d
     QRegularExpression regExp = regexpFromSearchBarOptions();
     _searchFilter->setRegExp(regExp);
 
+    // The previous search is outdated, stop it
+    if (!_searchTask.isNull()) {
+        _searchTask->cancel();
+    }
+
     if (_searchStartLine < 0 || _searchStartLine > view()->screenWindow()->lineCount()) {
         if (direction == Enum::ForwardsSearch) {
             setSearchStartTo(view()->screenWindow()->currentLine());
@@ -1734,6 +1731,7 @@ void SessionController::beginSearch(const QString &text, Enum::SearchDirection d
         task->setStartLine(_searchStartLine);
         task->addScreenWindow(session(), view()->screenWindow());
         task->execute();
+        _searchTask = task;
     } else if (text.isEmpty()) {
         view()->scrollBar()->clearSearchLines();
         searchCompleted(false);
@@ -29,7 +29,6 @@
 class QAction;
 class QTextCodec;
 class QKeyEvent;
-class QTimer;
 class QUrl;
 
 class KCodecAction;
@@ -54,6 +53,7 @@ class UrlFilter;
 class ColorFilter;
 class HotSpot;
 class SaveHistoryAutoTask;
+class SearchHistoryTask;
 
 /**
  * Provides the menu actions to manipulate a single terminal session and view pair.
@@ -389,8 +389,6 @@ private:
     QAction *_findNextAction;
     QAction *_findPreviousAction;
 
-    QTimer *_interactionTimer;
-
     int _searchStartLine;
     int _prevSearchResultLine;
 
@@ -430,6 +428,7 @@ private:
     QAction *_startAutoSaveAction;
     QAction *_stopAutoSaveAction;
     QPointer<SaveHistoryAutoTask> _autoSaveTask;
+    QPointer<SearchHistoryTask> _searchTask;
 
     QList<QAction *> contextMenuAdditionalActions;
 };
@@ -27,12 +27,15 @@
 #include <QLabel>
 #include <QMimeData>
 #include <QPainter>
+#include <QScreen>
 #include <QScrollEvent>
 #include <QScrollPrepareEvent>
 #include <QScroller>
 #include <QStyle>
 #include <QTimer>
 #include <QVBoxLayout>
+#include <QVarLengthArray>
+#include <QWindow>
 
 // KF
 #include <KColorScheme>
@@ -60,9 +63,9 @@
 #include "Emulation.h" // to connect the URL escape sequence extractor
 #include "EscapeSequenceUrlExtractor.h"
 #include "PrintOptions.h"
+#include "RenderStatistics.h"
 #include "Screen.h"
 #include "ViewManager.h" // for colorSchemeForProfile. // TODO: Rewrite this.
-#include "WindowSystemInfo.h"
 #include "profile/Profile.h"
 #include "session/Session.h"
 #include "session/SessionController.h"
@@ -126,6 +129,9 @@ void TerminalDisplay::setScreenWindow(ScreenWindow *window)
     _screenWindow = window;
 
     if (!_screenWindow.isNull()) {
+        if (isVisible()) {
+            updateRefreshRate();
+        }
         connect(_screenWindow.data(), &Konsole::ScreenWindow::outputChanged, this, &Konsole::TerminalDisplay::updateImage);
         connect(_screenWindow.data(), &Konsole::ScreenWindow::currentResultLineChanged, this, &Konsole::TerminalDisplay::updateImage);
         connect(_screenWindow.data(), &Konsole::ScreenWindow::outputChanged, this, [this]() {
@@ -145,7 +151,12 @@ void TerminalDisplay::setScreenWindow(ScreenWindow *window)
         if (_wallpaper->isAnimated()) {
             QTimer *frameTimer = new QTimer(this);
             connect(frameTimer, &QTimer::timeout, this, [this]() -> void {
-                update();
+                if (wallpaperInBackBuffer()) {
+                    _backBufferPending = rect();
+                    update();
+                } else {
+                    updateComposition(rect());
+                }
             });
             frameTimer->start(_wallpaper->getFrameDelay());
         }
@@ -256,6 +267,11 @@ TerminalDisplay::TerminalDisplay(QWidget *parent)
     _blinkCursorTimer->setInterval(QApplication::cursorFlashTime() / 2);
     connect(_blinkCursorTimer, &QTimer::timeout, this, &Konsole::TerminalDisplay::blinkCursorEvent);
 
+    _accessibilityTimer = new QTimer(this);
+    _accessibilityTimer->setSingleShot(true);
+    _accessibilityTimer->setInterval(ACCESSIBILITY_UPDATE_DELAY);
+    connect(_accessibilityTimer, &QTimer::timeout, this, &Konsole::TerminalDisplay::sendAccessibilityUpdates);
+
     // hide mouse cursor on keystroke or idle
     KCursor::setAutoHideCursor(this, true);
     setMouseTracking(true);
@@ -317,6 +333,9 @@ TerminalDisplay::TerminalDisplay(QWidget *parent)
 
     _terminalColor = new TerminalColor(this);
     connect(_terminalColor, &TerminalColor::onPalette, _scrollBar, &TerminalScrollBar::updatePalette);
+    connect(_terminalColor, &TerminalColor::onPalette, this, [this]() {
+        _backBufferPending = rect();
+    });
 
     _terminalPainter = new TerminalPainter(this);
 
@@ -394,6 +413,7 @@ void TerminalDisplay::showDragTarget(const QPoint &cursorPos)
 void TerminalDisplay::setKeyboardCursorShape(Enum::CursorShapeEnum shape)
 {
     _cursorShape = shape;
+    _cursorImageRect = QRect();
 }
 
 void TerminalDisplay::setCursorStyle(Enum::CursorShapeEnum shape, bool isBlinking, bool isAnimating, const QColor &customColor)
@@ -457,12 +477,15 @@ void TerminalDisplay::processFilters()
 
     const QRegion preUpdateHotSpots = _filterChain->hotSpotRegion();
 
-    // use _screenWindow->getImage() here rather than _image because
+    // use _screenWindow->frame() here rather than _image because
     // other classes may call processFilters() when this display's
     // ScreenWindow emits a scrolled() signal - which will happen before
     // updateImage() is called on the display and therefore _image is
     // out of date at this point
-    _filterChain->setImage(_screenWindow->getImage(), _screenWindow->windowLines(), _screenWindow->windowColumns(), _screenWindow->getLineProperties());
+    const ScreenWindow::Frame &frame = _screenWindow->frame();
+
+    RenderStatistics::Timer timer(_screenWindow->renderStatistics(), RenderStatistics::ProcessFilters);
+    _filterChain->setImage(frame.image, frame.lines, frame.columns, frame.lineProperties);
     _filterChain->process();
 
     const QRegion postUpdateHotSpots = _filterChain->hotSpotRegion();
@@ -483,24 +506,7 @@ void TerminalDisplay::updateImage()
     // optimization - scroll the existing image where possible and
     // avoid expensive text drawing for parts of the image that
     // can simply be moved up or down
-    // disable this shortcut for transparent konsole with scaled pixels, otherwise we get rendering artifacts, see BUG 350651
-    if (!(WindowSystemInfo::HAVE_TRANSPARENCY && (qApp->devicePixelRatio() > 1.0)) && _wallpaper->isNull() && !_searchBar->isVisible()) {
-        // if the flow control warning is enabled this will interfere with the
-        // scrolling optimizations and cause artifacts.  the simple solution here
-        // is to just disable the optimization whilst it is visible
-        if (!((_outputSuspendedMessageWidget != nullptr) && _outputSuspendedMessageWidget->isVisible())
-            && !((_readOnlyMessageWidget != nullptr) && _readOnlyMessageWidget->isVisible())) {
-            // hide terminal size label to prevent it being scrolled and show again after scroll
-            const bool viewResizeWidget = (_resizeWidget != nullptr) && _resizeWidget->isVisible();
-            if (viewResizeWidget) {
-                _resizeWidget->hide();
-            }
-            _scrollBar->scrollImage(_screenWindow->scrollCount(), _screenWindow->scrollRegion(), _image, _imageSize);
-            if (viewResizeWidget) {
-                _resizeWidget->show();
-            }
-        }
-    }
+    _scrollBar->scrollImage(_screenWindow->scrollCount(), _screenWindow->scrollRegion(), _image, _imageSize, _imageLineGenerations);
 
     if (_image == nullptr) {
         // Create _image.
@@ -508,10 +514,15 @@ void TerminalDisplay::updateImage()
         updateImageSize();
     }
 
-    Character *const newimg = _screenWindow->getImage();
-    const int lines = _screenWindow->windowLines();
-    const int columns = _screenWindow->windowColumns();
-    QVector<LineProperty> newLineProperties = _screenWindow->getLineProperties();
+    // the same frame as processFilters() unless the screen changed in between
+    const ScreenWindow::Frame &frame = _screenWindow->frame();
+
+    RenderStatistics::Timer timer(_screenWindow->renderStatistics(), RenderStatistics::UpdateImage);
+    const Character *const newimg = frame.image;
+    const int lines = frame.lines;
+    const int columns = frame.columns;
+    const QVector<LineProperty> newLineProperties = frame.lineProperties;
+    const QVector<quint64> newLineGenerations = frame.lineGenerations;
 
     _scrollBar->setScroll(_screenWindow->currentLine(), _screenWindow->lineCount());
 
@@ -534,6 +545,8 @@ void TerminalDisplay::updateImage()
 
     auto dirtyMask = new char[columnsToUpdate + 2];
     QRegion dirtyRegion;
+    // the first and last line of each run of lines which need to be repainted
+    QVarLengthArray<QPair<int, int>, MAX_DIRTY_LINE_RUNS> dirtyLines;
 
     std::optional<int> startDirtyIndex;
     std::optional<int> endDirtyIndex;
@@ -544,24 +557,38 @@ void TerminalDisplay::updateImage()
 
         bool updateLine = false;
 
-        // The dirty mask indicates which characters need repainting. We also
-        // mark surrounding neighbors dirty, in case the character exceeds
-        // its cell boundaries
-        memset(dirtyMask, 0, columnsToUpdate + 2);
+        // the line is in _image already if it has the same generation,
+        // so there is no need to compare or copy its characters
+        const quint64 generation = (columns == _columns) ? newLineGenerations.value(y) : 0;
+        const bool unchanged = (generation != 0 && generation == _imageLineGenerations.value(y));
+        if (y < _imageLineGenerations.size()) {
+            _imageLineGenerations[y] = generation;
+        }
 
-        for (x = 0; x < columnsToUpdate; ++x) {
-            if (newLine[x] != currentLine[x]) {
-                dirtyMask[x] = 1;
+        if (unchanged) {
+            for (x = 0; x < columnsToUpdate && !_hasTextBlinker; ++x) {
+                _hasTextBlinker |= currentLine[x].rendition.f.blink;
+            }
+        } else {
+            // The dirty mask indicates which characters need repainting. We also
+            // mark surrounding neighbors dirty, in case the character exceeds
+            // its cell boundaries
+            memset(dirtyMask, 0, columnsToUpdate + 2);
+
+            for (x = 0; x < columnsToUpdate; ++x) {
+                if (newLine[x] != currentLine[x]) {
+                    dirtyMask[x] = 1;
 
-                const int indexInImage = (y * columns) + x;
-                if (!startDirtyIndex) {
-                    startDirtyIndex = indexInImage;
+                    const int indexInImage = (y * columns) + x;
+                    if (!startDirtyIndex) {
+                        startDirtyIndex = indexInImage;
+                    }
+                    endDirtyIndex = indexInImage;
                 }
-                endDirtyIndex = indexInImage;
             }
         }
 
-        if (!_resizing) { // not while _resizing, we're expecting a paintEvent
+        if (!_resizing && !unchanged) { // not while _resizing, we're expecting a paintEvent
             for (x = 0; x < columnsToUpdate; ++x) {
                 _hasTextBlinker |= newLine[x].rendition.f.blink;
 
@@ -607,22 +634,42 @@ void TerminalDisplay::updateImage()
         // if the characters on the line are different in the old and the new _image
         // then this line must be repainted.
         if (updateLine) {
-            // add the area occupied by this line to the region which needs to be
-            // repainted
-            QRect dirtyRect = QRect(_contentRect.left() + tLx,
-                                    _contentRect.top() + tLy + _terminalFont->fontHeight() * y,
-                                    _terminalFont->fontWidth() * columnsToUpdate,
-                                    _terminalFont->fontHeight());
-
-            dirtyRegion |= highdpi_adjust_rect(dirtyRect);
+            // add the line to the run of lines before it if at most one
+            // unchanged line is in between, repainting that line is cheaper
+            // than another rectangle in the region which needs to be repainted
+            if (!dirtyLines.isEmpty() && dirtyLines.last().second >= y - 2) {
+                dirtyLines.last().second = y;
+            } else if (dirtyLines.size() == MAX_DIRTY_LINE_RUNS) {
+                // with lines changing all over the display, e.g. when a full
+                // screen application redraws, it is cheaper to repaint all
+                // lines in between
+                const int firstLine = dirtyLines.first().first;
+                dirtyLines.clear();
+                dirtyLines.append({firstLine, y});
+            } else {
+                dirtyLines.append({y, y});
+            }
         }
 
         // replace the line of characters in the old _image with the
         // current line of the new _image
-        memcpy((void *)currentLine, (const void *)newLine, columnsToUpdate * sizeof(Character));
+        if (!unchanged) {
+            memcpy((void *)currentLine, (const void *)newLine, columnsToUpdate * sizeof(Character));
+        }
     }
     _lineProperties = newLineProperties;
 
+    // add the area occupied by the lines to the region which needs to be
+    // repainted
+    for (const auto &[firstLine, lastLine] : std::as_const(dirtyLines)) {
+        const QRect dirtyRect = QRect(_contentRect.left() + tLx,
+                                      _contentRect.top() + tLy + _terminalFont->fontHeight() * firstLine,
+                                      _terminalFont->fontWidth() * columnsToUpdate,
+                                      _terminalFont->fontHeight() * (lastLine - firstLine + 1));
+
+        dirtyRegion |= highdpi_adjust_rect(dirtyRect);
+    }
+
     // if the new _image is smaller than the previous _image, then ensure that the area
     // outside the new _image is cleared
     if (linesToUpdate < _usedLines) {
@@ -661,8 +708,10 @@ void TerminalDisplay::updateImage()
 
     // update the parts of the display which have changed
     if (_screenWindow->screen()->hasGraphics()) {
+        _backBufferPending = rect();
         update();
     } else {
+        _backBufferPending |= dirtyRegion;
         update(dirtyRegion);
     }
 
@@ -676,6 +725,32 @@ void TerminalDisplay::updateImage()
     delete[] dirtyMask;
 
 #ifndef QT_NO_ACCESSIBILITY
+    // the changes are only of interest to assistive technologies, which are
+    // told about them at most every ACCESSIBILITY_UPDATE_DELAY milliseconds
+    if (QAccessible::isActive()) {
+        if (startDirtyIndex && endDirtyIndex) {
+            _accessibleStartDirtyIndex = qMin(*startDirtyIndex, _accessibleStartDirtyIndex.value_or(*startDirtyIndex));
+            _accessibleEndDirtyIndex = qMax(*endDirtyIndex, _accessibleEndDirtyIndex.value_or(*endDirtyIndex));
+        }
+        if (!_accessibilityTimer->isActive()) {
+            _accessibilityTimer->start();
+        }
+    }
+#endif
+}
+
+void TerminalDisplay::sendAccessibilityUpdates()
+{
+#ifndef QT_NO_ACCESSIBILITY
+    std::optional<int> startDirtyIndex;
+    std::optional<int> endDirtyIndex;
+    std::swap(startDirtyIndex, _accessibleStartDirtyIndex);
+    std::swap(endDirtyIndex, _accessibleEndDirtyIndex);
+
+    if (_screenWindow.isNull() || !QAccessible::isActive()) {
+        return;
+    }
+
     QAccessibleEvent dataChangeEvent(this, QAccessible::VisibleDataChanged);
     QAccessible::updateAccessibility(&dataChangeEvent);
     QAccessibleTextCursorEvent cursorEvent(this, _usedColumns * screenWindow()->screen()->getCursorY() + screenWindow()->screen()->getCursorX());
@@ -736,35 +811,139 @@ void TerminalDisplay::paintEvent(QPaintEvent *pe)
 
     QPainter paint(this);
 
-    // Determine which characters should be repainted (1 region unit = 1 character)
-    QRegion dirtyImageRegion;
     const QRegion region = pe->region() & contentsRect();
 
-    for (const QRect &rect : region) {
-        dirtyImageRegion += widgetToImage(rect);
-        // We can use the opacity settings only if we are in a top level window which actually supports opacity.
-        // Many apps that use a konsole part such as kate or dolphin don't for performance reasons.
-        // This will result in repaint glitches iin wayland due to missing damage information
-        const bool useOpacity = window() && window()->testAttribute(Qt::WA_TranslucentBackground);
-        _terminalPainter->drawBackground(paint, rect, _terminalColor->backgroundColor(), useOpacity);
-    }
+    // We can use the opacity settings only if we are in a top level window which actually supports opacity.
+    // Many apps that use a konsole part such as kate or dolphin don't for performance reasons.
+    // This will result in repaint glitches iin wayland due to missing damage information
+    const bool useOpacity = window() && window()->testAttribute(Qt::WA_TranslucentBackground);
+    // the lines are drawn over a transparent back buffer if the window shows
+    // through them, otherwise over the wallpaper or the background color, so
+    // that the text keeps its subpixel antialiasing
+    const bool transparentBackBuffer = useOpacity && qAlpha(_terminalColor->blendColor()) < 0xff;
+    const QImage::Format backBufferFormat = transparentBackBuffer ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    const qreal dpr = devicePixelRatioF();
+    const QSize backBufferSize = size() * dpr;
+
+    const auto createImage = [&](const QSize &size) {
+        QImage image(size * dpr, backBufferFormat);
+        image.setDevicePixelRatio(dpr);
+        // fonts are sized for the screen, not for the default resolution of images
+        image.setDotsPerMeterX(qRound(logicalDpiX() / 0.0254));
+        image.setDotsPerMeterY(qRound(logicalDpiY() / 0.0254));
+        return image;
+    };
+    // clears 'rect' of an image before the lines are drawn into it
+    const auto clearLines = [&](QPainter &painter, const QRect &rect) {
+        if (transparentBackBuffer) {
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            painter.fillRect(rect, Qt::transparent);
+            painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        } else {
+            _terminalPainter->drawBackground(painter, rect, _terminalColor->backgroundColor(), useOpacity);
+        }
 
-    if (_displayVerticalLine) {
-        const int fontWidth = _terminalFont->fontWidth();
-        const int x = (fontWidth / 2) + (fontWidth * _displayVerticalLineAtChar);
-        const QColor lineColor = _terminalColor->foregroundColor();
+        if (_displayVerticalLine) {
+            const int fontWidth = _terminalFont->fontWidth();
+            const int x = (fontWidth / 2) + (fontWidth * _displayVerticalLineAtChar);
+            const QColor lineColor = _terminalColor->foregroundColor();
 
-        paint.setPen(lineColor);
-        paint.drawLine(QPoint(x, 0), QPoint(x, height()));
-    }
+            painter.setPen(lineColor);
+            painter.drawLine(QPoint(x, rect.top()), QPoint(x, rect.bottom()));
+        }
+    };
 
-    // only turn on text anti-aliasing, never turn on normal antialiasing
-    // set https://bugreports.qt.io/browse/QTBUG-66036
-    paint.setRenderHint(QPainter::TextAntialiasing, _terminalFont->antialiasText());
+    if (_backBuffer.size() != backBufferSize || _backBuffer.format() != backBufferFormat || _backBuffer.devicePixelRatio() != dpr) {
+        _backBuffer = createImage(size());
+        _backBufferPending = rect();
+    }
+
+    // The lines which didn't change, e.g. because they only scrolled or the
+    // cursor blinked, are copied from the back buffer
+    const QRegion backBufferRegion = region - (_backBufferUnchanged - _backBufferPending);
+    RenderStatistics *const statistics = _screenWindow ? _screenWindow->renderStatistics() : nullptr;
+
+    if (!backBufferRegion.isEmpty()) {
+        QPainter bufferPaint(&_backBuffer);
+        // unlike a painter on the widget, a painter on an image doesn't start
+        // with the widget's font, nor with its viewport, by which the
+        // wallpaper is scaled
+        bufferPaint.setFont(font());
+        bufferPaint.setViewport(rect());
+        bufferPaint.setWindow(rect());
+        bufferPaint.setClipRegion(backBufferRegion);
+
+        // Determine which characters should be repainted (1 region unit = 1 character)
+        QRegion dirtyImageRegion;
+        for (const QRect &rect : backBufferRegion) {
+            dirtyImageRegion += widgetToImage(rect);
+            clearLines(bufferPaint, rect);
+        }
+
+        // only turn on text anti-aliasing, never turn on normal antialiasing
+        // set https://bugreports.qt.io/browse/QTBUG-66036
+        bufferPaint.setRenderHint(QPainter::TextAntialiasing, _terminalFont->antialiasText());
+
+        for (const QRect &rect : std::as_const(dirtyImageRegion)) {
+            RenderStatistics::Timer timer(statistics, RenderStatistics::DrawContents);
+            _terminalPainter->drawContents(_image,
+                                           bufferPaint,
+                                           rect,
+                                           false,
+                                           _imageSize,
+                                           _bidiEnabled,
+                                           _lineProperties,
+                                           _screenWindow->screen()->ulColorTable(),
+                                           false);
+        }
+    }
+    _backBufferPending -= backBufferRegion;
+    _backBufferUnchanged -= region;
 
-    for (const QRect &rect : std::as_const(dirtyImageRegion)) {
-        _terminalPainter->drawContents(_image, paint, rect, false, _imageSize, _bidiEnabled, _lineProperties, _screenWindow->screen()->ulColorTable());
-    }
+    for (const QRect &rect : region) {
+        if (transparentBackBuffer) {
+            _terminalPainter->drawBackground(paint, rect, _terminalColor->backgroundColor(), useOpacity);
+        }
+        paint.drawImage(QRectF(rect), _backBuffer, QRectF(QPointF(rect.topLeft()) * dpr, QSizeF(rect.size()) * dpr));
+    }
+
+    // The cursor isn't part of the back buffer, so that it can blink and move
+    // without drawing the lines again. The cells around it are drawn with the
+    // cursor into _cursorImage when they change.
+    const QRect cursorArea = cursorRect();
+    if (_cursorImageRect != cursorArea || backBufferRegion.intersects(cursorArea) || _cursorImage.format() != backBufferFormat
+        || _cursorImage.devicePixelRatio() != dpr) {
+        _cursorImageRect = QRect();
+    }
+    if (!_cursorBlinking && region.intersects(cursorArea)) {
+        if (_cursorImageRect.isNull()) {
+            _cursorImage = createImage(cursorArea.size());
+
+            QPainter cursorPaint(&_cursorImage);
+            cursorPaint.setFont(font());
+            // draw in widget coordinates, with the viewport of the widget
+            cursorPaint.setViewport(QRect(-cursorArea.topLeft(), size()));
+            cursorPaint.setWindow(rect());
+            clearLines(cursorPaint, cursorArea);
+            cursorPaint.setRenderHint(QPainter::TextAntialiasing, _terminalFont->antialiasText());
+            RenderStatistics::Timer timer(statistics, RenderStatistics::DrawContents);
+            _terminalPainter->drawContents(_image,
+                                           cursorPaint,
+                                           widgetToImage(cursorArea),
+                                           false,
+                                           _imageSize,
+                                           _bidiEnabled,
+                                           _lineProperties,
+                                           _screenWindow->screen()->ulColorTable());
+            _cursorImageRect = cursorArea;
+        }
+
+        if (transparentBackBuffer) {
+            _terminalPainter->drawBackground(paint, cursorArea, _terminalColor->backgroundColor(), useOpacity);
+        }
+        paint.drawImage(cursorArea.topLeft(), _cursorImage);
+    }
+    _terminalPainter->drawCursorAnimation(paint);
 
     if (screenWindow()->currentResultLine() != -1) {
         _searchResultRect.setRect(0,
@@ -1031,6 +1210,7 @@ void TerminalDisplay::focusOutEvent(QFocusEvent *)
     //   * visible (in case it was hidden during blinking)
     //   * drawn in a focused out state
     _cursorBlinking = false;
+    _cursorImageRect = QRect();
     updateCursor();
 
     // suppress further cursor blinking
@@ -1056,6 +1236,7 @@ void TerminalDisplay::focusInEvent(QFocusEvent *)
         _blinkCursorTimer->start();
     }
 
+    _cursorImageRect = QRect();
     updateCursor();
 
     if (_allowBlinkingText && _hasTextBlinker) {
@@ -1068,6 +1249,7 @@ void TerminalDisplay::blinkTextEvent()
     Q_ASSERT(_allowBlinkingText);
 
     _textBlinking = !_textBlinking;
+    _backBufferPending = rect();
 
     // TODO: Optimize to only repaint the areas of the widget where there is
     // blinking text rather than repainting the whole widget.
@@ -1088,12 +1270,78 @@ void TerminalDisplay::updateCursor()
         return;
     }
 
+    updateComposition(cursorRect());
+}
+
+QRect TerminalDisplay::cursorRect() const
+{
+    if (_image == nullptr || !isCursorOnDisplay()) {
+        return {};
+    }
+
     const int cursorLocation = loc(cursorPosition().x(), cursorPosition().y());
     Q_ASSERT(cursorLocation < _imageSize);
 
     int charWidth = _image[cursorLocation].width();
-    QRect cursorRect = imageToWidget(highdpi_adjust_rect(QRect(_visualCursorPosition, QSize(charWidth, 1))));
-    update(cursorRect);
+    return imageToWidget(highdpi_adjust_rect(QRect(_visualCursorPosition, QSize(charWidth, 1))));
+}
+
+void TerminalDisplay::updateComposition(const QRegion &region)
+{
+    _backBufferUnchanged |= region;
+    update(region);
+}
+
+void TerminalDisplay::scrollBackBuffer(const QRect &rect, int dy)
+{
+    updateComposition(rect);
+    if (rect.intersects(_cursorImageRect)) {
+        _cursorImageRect = QRect();
+    }
+
+    // The lines can only be moved by whole rows of pixels. The images drawn
+    // over the lines aren't part of _image, so they are always drawn again,
+    // as are the lines over a wallpaper in the back buffer, which stays in
+    // place.
+    const qreal dpr = _backBuffer.devicePixelRatio();
+    const auto isWholePixels = [dpr](int length) {
+        return qFuzzyCompare(length * dpr, qRound(length * dpr));
+    };
+    const int firstRow = qRound(rect.top() * dpr);
+    const int rows = qRound(rect.height() * dpr);
+    const int shift = qRound(dy * dpr);
+    const int rowsToMove = rows - qAbs(shift);
+    if (_backBuffer.isNull() || wallpaperInBackBuffer() || _screenWindow->screen()->hasGraphics() || !isWholePixels(rect.top()) || !isWholePixels(rect.height())
+        || !isWholePixels(dy) || firstRow < 0 || firstRow + rows > _backBuffer.height() || rowsToMove <= 0) {
+        _backBufferPending |= rect;
+        return;
+    }
+
+    uchar *bits = _backBuffer.bits();
+    const qsizetype bytesPerLine = _backBuffer.bytesPerLine();
+    memmove(bits + (firstRow + qMax(shift, 0)) * bytesPerLine, bits + (firstRow + qMax(-shift, 0)) * bytesPerLine, rowsToMove * bytesPerLine);
+
+    // the parts which weren't drawn yet move along with the lines, the
+    // newly exposed lines still show what they showed before, like the
+    // lines of _image do
+    const QRect source = rect.adjusted(0, qMax(-dy, 0), 0, -qMax(dy, 0));
+    const QRegion pending = _backBufferPending & source;
+    _backBufferPending -= source.translated(0, dy);
+    _backBufferPending |= pending.translated(0, dy);
+}
+
+void TerminalDisplay::updateRefreshRate()
+{
+    if (_screenWindow.isNull()) {
+        return;
+    }
+    const QScreen *shownOn = screen();
+    _screenWindow->setRefreshRate(shownOn != nullptr ? shownOn->refreshRate() : 0);
+}
+
+bool TerminalDisplay::wallpaperInBackBuffer() const
+{
+    return !_wallpaper->isNull() && !_backBuffer.isNull() && !_backBuffer.hasAlphaChannel();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -1187,6 +1435,8 @@ void TerminalDisplay::makeImage()
 void TerminalDisplay::clearImage()
 {
     std::fill(_image, _image + _imageSize, Screen::DefaultChar);
+    _imageLineGenerations.fill(0, _lines);
+    _backBufferPending = rect();
 }
 
 void TerminalDisplay::calcGeometry()
@@ -1233,6 +1483,9 @@ void TerminalDisplay::calcGeometry()
         QSize unusedPixels = _contentRect.size() - QSize(_columns * fontWidth, _lines * _terminalFont->fontHeight());
         _contentRect.adjust(unusedPixels.width() / 2, unusedPixels.height() / 2, 0, 0);
     }
+
+    // the lines are drawn somewhere else now
+    _backBufferPending = rect();
 }
 
 // calculate the needed size, this must be synced with calcGeometry()
@@ -1264,9 +1517,28 @@ void TerminalDisplay::showEvent(QShowEvent *)
 {
     propagateSize();
     Q_EMIT changedContentSizeSignal(_contentRect.height(), _contentRect.width());
+
+    // the window may have changed, e.g. when the tab was detached
+    if (QWindow *windowHandle = window()->windowHandle()) {
+        connect(windowHandle, &QWindow::screenChanged, this, &TerminalDisplay::updateRefreshRate, Qt::UniqueConnection);
+    }
+    updateRefreshRate();
 }
 void TerminalDisplay::hideEvent(QHideEvent *)
 {
+    // don't keep an image of the whole widget for each hidden tab,
+    // paintEvent() draws them again when the display is shown
+    _backBuffer = QImage();
+    _backBufferPending = rect();
+    _backBufferUnchanged = QRegion();
+    _cursorImage = QImage();
+    _cursorImageRect = QRect();
+
+    // the emulation is paced by the screens of the views which are shown
+    if (!_screenWindow.isNull()) {
+        _screenWindow->setRefreshRate(0);
+    }
+
     Q_EMIT changedContentSizeSignal(_contentRect.height(), _contentRect.width());
 }
 
@@ -1744,7 +2016,7 @@ QPair<int, int> TerminalDisplay::getCharacterPosition(const QPoint &widgetPoint,
         qBound(0, (widgetPoint.x() + xOffset - contentsRect().left() - _contentRect.left()) / _terminalFont->fontWidth() / (doubleWidth ? 2 : 1), columnMax);
 
     // Visual column to logical
-    if (_bidiEnabled && column < _usedColumns) {
+    if (_bidiEnabled && column < _usedColumns && lineNeedsBidi(_image + loc(0, line))) {
         int log2line[MAX_LINE_WIDTH];
         int line2log[MAX_LINE_WIDTH];
         uint16_t shapemap[MAX_LINE_WIDTH];
@@ -3321,6 +3593,9 @@ void TerminalDisplay::applyProfile(const Profile::Ptr &profile)
     // load font
     _terminalFont->applyProfile(profile);
 
+    _terminalPainter->applyProfile(profile);
+    _backBufferPending = rect();
+
     // set scroll-bar position
     _scrollBar->setScrollBarPosition(Enum::ScrollBarPositionEnum(profile->property<int>(Profile::ScrollBarPosition)));
     _scrollBar->setScrollFullPage(profile->property<bool>(Profile::ScrollFullPage));
@@ -3573,6 +3848,16 @@ int TerminalDisplay::bidiMap(Character *screenline,
     return _bidiLineLTR ? lastNonSpace : linewidth - 1;
 }
 
+bool TerminalDisplay::lineNeedsBidi(const Character *screenline) const
+{
+    for (int i = 0; i < _usedColumns; i++) {
+        if ((screenline[i].flags & EF_BIDI) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void TerminalDisplay::clearSelection()
 {
     _screenWindow->clearSelection();
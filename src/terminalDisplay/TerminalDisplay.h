@@ -10,10 +10,13 @@
 
 // Qt
 #include <QColor>
+#include <QImage>
 #include <QPointer>
+#include <QRegion>
 #include <QWidget>
 
 #include <memory>
+#include <optional>
 
 // Konsole
 #include "../characters/Character.h"
@@ -431,6 +434,27 @@ public:
                 bool shape = true,
                 bool bidi = true) const;
 
+    // Returns true if the line needs bidiMap() to be displayed, i.e. it
+    // contains characters which are reordered or shaped.
+    bool lineNeedsBidi(const Character *screenline) const;
+
+    // Schedules a repaint of 'region' which doesn't change the lines drawn
+    // there, e.g. for the cursor, so that they are copied from the back buffer.
+    void updateComposition(const QRegion &region);
+
+    // Moves the lines drawn in 'rect' by 'dy' pixels, like QWidget::scroll()
+    // does, and schedules a repaint of 'rect' which copies the moved lines
+    // instead of drawing them again.
+    void scrollBackBuffer(const QRect &rect, int dy);
+
+    // Tells the screen window the refresh rate of the screen which this
+    // display is shown on, by which the emulation paces its updates.
+    void updateRefreshRate();
+
+    // Returns true if the wallpaper is drawn into the back buffer, under the
+    // lines, so that it has to be drawn again when the lines move.
+    bool wallpaperInBackBuffer() const;
+
     void showNotification(QString text);
 
     //
@@ -618,6 +642,9 @@ private Q_SLOTS:
 
     void viewScrolledByUser();
 
+    // tells assistive technologies about the changes collected by updateImage()
+    void sendAccessibilityUpdates();
+
 private:
     Q_DISABLE_COPY(TerminalDisplay)
 
@@ -641,6 +668,8 @@ private:
 
     // redraws the cursor
     void updateCursor();
+    // the part of the widget occupied by the cursor
+    QRect cursorRect() const;
 
     bool handleShortcutOverrideEvent(QKeyEvent *keyEvent);
 
@@ -719,6 +748,25 @@ private:
 
     int _imageSize = 0;
     QVector<LineProperty> _lineProperties;
+    // generation of each line of _image, see Screen::lineGeneration()
+    QVector<quint64> _imageLineGenerations;
+
+    // The lines drawn by paintEvent(). In a translucent window they are drawn
+    // over a transparent background, and copied over the translucent
+    // background and the wallpaper of the widget, at the cost of subpixel
+    // antialiasing of the text. Otherwise the buffer is opaque, and has the
+    // wallpaper under the lines, see wallpaperInBackBuffer().
+    QImage _backBuffer;
+    // the parts of _backBuffer which don't show _image yet
+    QRegion _backBufferPending;
+    // the parts of the widget which are repainted without changes to their
+    // lines, e.g. because they scrolled, and are copied from _backBuffer
+    QRegion _backBufferUnchanged;
+    // The cells around the cursor, drawn with the cursor, which isn't part of
+    // _backBuffer. _cursorImageRect is the part of the widget they are drawn
+    // for, or empty if they have to be drawn again.
+    QImage _cursorImage;
+    QRect _cursorImageRect;
 
     QColor _colorTable[TABLE_COLORS];
 
@@ -758,6 +806,13 @@ private:
     QTimer *_blinkTextTimer = nullptr;
     QTimer *_blinkCursorTimer = nullptr;
 
+    // delays sendAccessibilityUpdates(), so that assistive technologies aren't
+    // told about every update of the display
+    QTimer *_accessibilityTimer = nullptr;
+    // the range of characters which changed since sendAccessibilityUpdates()
+    std::optional<int> _accessibleStartDirtyIndex;
+    std::optional<int> _accessibleEndDirtyIndex;
+
     bool _openLinksByDirectClick = false; // Open URL and hosts by single mouse click
 
     bool _ctrlRequiredForDrag = true; // require Ctrl key for drag selected text
@@ -800,6 +855,13 @@ private:
     // the duration of the size hint in milliseconds
     static const int SIZE_HINT_DURATION = 1000;
 
+    // the delay in milliseconds between updates for assistive technologies
+    static const int ACCESSIBILITY_UPDATE_DELAY = 100;
+
+    // the number of separate runs of changed lines which updateImage()
+    // repaints, with more the lines in between are repainted too
+    static const int MAX_DIRTY_LINE_RUNS = 8;
+
     SessionController *_sessionController = nullptr;
 
     bool _trimLeadingSpaces = false; // trim leading spaces in selected text
@@ -19,11 +19,16 @@
 // Qt
 #include <QFont>
 #include <QFontMetrics>
+#include <QTextLayout>
+
+// Number of code points whose glyphs are cached, see fallbackGlyph()
+static const int FALLBACK_GLYPH_CACHE_SIZE = 4096;
 
 namespace Konsole
 {
 TerminalFont::TerminalFont(QWidget *parent)
     : m_parent(parent)
+    , m_fallbackGlyphs(FALLBACK_GLYPH_CACHE_SIZE)
 {
 }
 
@@ -45,6 +50,7 @@ void TerminalFont::applyProfile(const Profile::Ptr &profile)
             extraFonts.remove(0);
         }
     }
+    m_fallbackGlyphs.clear();
 }
 
 void TerminalFont::setVTFont(const QFont &f)
@@ -127,6 +133,7 @@ void TerminalFont::setVTFont(const QFont &f)
     }
 
     qobject_cast<QWidget *>(m_parent)->setFont(newFont);
+    m_fallbackGlyphs.clear();
     fontChange(newFont);
 }
 
@@ -260,4 +267,28 @@ QFont TerminalFont::getExtraFont(int i) const
 {
     return extraFonts[i];
 }
+
+const QGlyphRun *TerminalFont::fallbackGlyph(char32_t ucs4, const QFont &font, bool extraFont, QPaintDevice *device)
+{
+    const FallbackGlyphKey key{ucs4, device->logicalDpiY(), font.weight(), font.italic(), extraFont};
+    QGlyphRun *glyph = m_fallbackGlyphs.object(key);
+    if (glyph == nullptr) {
+        glyph = new QGlyphRun();
+
+        // QTextLayout resolves the font fallback like QPainter::drawText() does
+        QTextLayout layout(QString::fromUcs4(&ucs4, 1), font, device);
+        layout.beginLayout();
+        const QTextLine line = layout.createLine();
+        layout.endLayout();
+
+        const QList<QGlyphRun> glyphRuns = layout.glyphRuns();
+        if (line.isValid() && glyphRuns.size() == 1 && glyphRuns[0].glyphIndexes().size() == 1) {
+            *glyph = glyphRuns[0];
+            glyph->setPositions({glyph->positions().constFirst() - QPointF(0, line.ascent())});
+        }
+        m_fallbackGlyphs.insert(key, glyph);
+    }
+
+    return glyph->isEmpty() ? nullptr : glyph;
+}
 }
@@ -9,12 +9,15 @@
 #ifndef TERMINALFONTS_H
 #define TERMINALFONTS_H
 
+#include <QCache>
+#include <QGlyphRun>
 #include <QWidget>
 
 #include "konsoleprivate_export.h"
 #include "profile/Profile.h"
 
 class QFont;
+class QPaintDevice;
 
 namespace Konsole
 {
@@ -51,6 +54,14 @@ public:
     bool hasExtraFont(int i) const;
     QFont getExtraFont(int i) const;
 
+    // Returns the glyph of the code point 'ucs4' in the font chosen for it by
+    // font fallback when drawing with 'font', the terminal font or an extra
+    // font with the given weight and style, on 'device'. The glyph
+    // is positioned with its baseline at 0. The font fallback is resolved
+    // once per code point until the terminal font changes.
+    // Returns nullptr if the code point isn't drawn as a single glyph.
+    const QGlyphRun *fallbackGlyph(char32_t ucs4, const QFont &font, bool extraFont, QPaintDevice *device);
+
 protected:
     void fontChange(const QFont &);
 
@@ -70,6 +81,27 @@ private:
     bool m_useFontBrailleCharacters = true;
     QMap<int, QFont> extraFonts;
 
+    struct FallbackGlyphKey {
+        char32_t ucs4;
+        int dpi;
+        int weight;
+        bool italic;
+        bool extraFont;
+
+        bool operator==(const FallbackGlyphKey &other) const
+        {
+            return ucs4 == other.ucs4 && dpi == other.dpi && weight == other.weight && italic == other.italic && extraFont == other.extraFont;
+        }
+
+        friend size_t qHash(const FallbackGlyphKey &key, size_t seed = 0) noexcept
+        {
+            return qHashMulti(seed, key.ucs4, key.dpi, key.weight, key.italic, key.extraFont);
+        }
+    };
+    // see fallbackGlyph(), an empty glyph run is cached for code points which
+    // aren't drawn as a single glyph
+    QCache<FallbackGlyphKey, QGlyphRun> m_fallbackGlyphs;
+
     Profile::Ptr m_profile;
 };
 
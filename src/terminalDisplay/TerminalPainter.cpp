@@ -13,7 +13,6 @@
 #include "../Screen.h"
 #include "../characters/LineBlockCharacters.h"
 #include "../filterHotSpots/FilterChain.h"
-#include "../session/SessionManager.h"
 #include "TerminalColor.h"
 #include "TerminalFonts.h"
 #include "TerminalScrollBar.h"
@@ -29,6 +28,7 @@
 #include <QRect>
 #include <QRegion>
 #include <QString>
+#include <QTextLayout>
 #include <QTransform>
 #include <QtMath>
 
@@ -38,6 +38,10 @@
 // more information can be found in: https://unicode.org/reports/tr9/
 const QChar LTR_OVERRIDE_CHAR(0x202D);
 
+// Number of text fragments, mostly single characters or words, whose glyph
+// runs are cached
+static const int GLYPH_RUN_CACHE_SIZE = 8192;
+
 namespace Konsole
 {
 QVariant interpolatePolygonF(const QPolygonF &start, const QPolygonF &end, qreal progress)
@@ -57,17 +61,22 @@ QVariant interpolatePolygonF(const QPolygonF &start, const QPolygonF &end, qreal
 TerminalPainter::TerminalPainter(TerminalDisplay *parent)
     : QObject(parent)
     , m_parentDisplay(parent)
+    , m_glyphRunCache(GLYPH_RUN_CACHE_SIZE)
 {
     qRegisterAnimationInterpolator<QPolygonF>(interpolatePolygonF);
     m_cursorAnim = new QVariantAnimation(this);
     m_cursorAnim->setDuration(200);
     m_cursorAnim->setEasingCurve(QEasingCurve::OutCubic);
     connect(m_cursorAnim, &QVariantAnimation::valueChanged, this, &TerminalPainter::updateCursorAnimation);
+    connect(m_cursorAnim, &QVariantAnimation::finished, this, [this]() {
+        m_parentDisplay->updateComposition(m_animatedCursorPolygon.boundingRect().toAlignedRect().adjusted(-1, -1, 1, 1));
+    });
 }
 void TerminalPainter::updateCursorAnimation(const QVariant &value)
 {
+    const QRectF oldRect = m_animatedCursorPolygon.boundingRect();
     m_animatedCursorPolygon = value.value<QPolygonF>();
-    m_parentDisplay->update();
+    m_parentDisplay->updateComposition((oldRect | m_animatedCursorPolygon.boundingRect()).toAlignedRect().adjusted(-1, -1, 1, 1));
 }
 QPolygonF createDynamicPolygon(const QRectF &rect, qreal shear, qreal taper)
 {
@@ -203,6 +212,22 @@ std::optional<QColor> calculateBackgroundColor(const Character style, const QCol
     return (contrast1 < contrast2) ? blend1 : blend2;
 }
 
+void TerminalPainter::applyProfile(const Profile::Ptr &profile)
+{
+    m_profileSettings.wordMode = profile->property<bool>(Profile::WordMode);
+    m_profileSettings.wordModeAttr = profile->property<bool>(Profile::WordModeAttr);
+    m_profileSettings.wordModeAscii = profile->property<bool>(Profile::WordModeAscii);
+    m_profileSettings.wordModeBrahmic = profile->property<bool>(Profile::WordModeBrahmic);
+    m_profileSettings.wordModeCoding = profile->property<bool>(Profile::WordModeCoding);
+    m_profileSettings.invertedRendition = profile->property<bool>(Profile::InvertSelectionColors);
+    m_profileSettings.semanticHints = static_cast<Enum::Hints>(profile->semanticHints());
+    m_profileSettings.lineNumbers = static_cast<Enum::Hints>(profile->lineNumbers());
+    m_profileSettings.errorBars = static_cast<Enum::Hints>(profile->property<int>(Profile::ErrorBars));
+    m_profileSettings.errorBackground = static_cast<Enum::Hints>(profile->property<int>(Profile::ErrorBackground));
+    m_profileSettings.alternatingBars = static_cast<Enum::Hints>(profile->property<int>(Profile::AlternatingBars));
+    m_profileSettings.alternatingBackground = static_cast<Enum::Hints>(profile->property<int>(Profile::AlternatingBackground));
+}
+
 static void reverseRendition(Character &p)
 {
     CharacterColor f = p.foregroundColor;
@@ -218,23 +243,22 @@ void TerminalPainter::drawContents(Character *image,
                                    bool printerFriendly,
                                    int imageSize,
                                    bool bidiEnabled,
-                                   QVector<LineProperty> lineProperties,
-                                   CharacterColor const *ulColorTable)
+                                   const QVector<LineProperty> &lineProperties,
+                                   CharacterColor const *ulColorTable,
+                                   bool withCursor)
 {
-    auto currentProfile = SessionManager::instance()->sessionProfile(m_parentDisplay->session());
-    const bool wordMode = currentProfile ? currentProfile->property<bool>(Profile::WordMode) : false;
-    const bool wordModeAttr = currentProfile ? currentProfile->property<bool>(Profile::WordModeAttr) : true;
-    const bool wordModeAscii = currentProfile ? currentProfile->property<bool>(Profile::WordModeAscii) : true;
-    const bool wordModeBrahmic = currentProfile ? currentProfile->property<bool>(Profile::WordModeBrahmic) : true;
-    const bool wordModeCoding = currentProfile ? currentProfile->property<bool>(Profile::WordModeCoding) : true;
-    const bool invertedRendition = currentProfile ? currentProfile->property<bool>(Profile::InvertSelectionColors) : false;
-    const Enum::Hints semanticHints = currentProfile ? static_cast<Enum::Hints>(currentProfile->semanticHints()) : Enum::HintsNever;
-    const Enum::Hints lineNumbers = currentProfile ? static_cast<Enum::Hints>(currentProfile->lineNumbers()) : Enum::HintsNever;
-    const Enum::Hints errorBars = currentProfile ? static_cast<Enum::Hints>(currentProfile->property<int>(Profile::ErrorBars)) : Enum::HintsNever;
-    const Enum::Hints errorBackground = currentProfile ? static_cast<Enum::Hints>(currentProfile->property<int>(Profile::ErrorBackground)) : Enum::HintsNever;
-    const Enum::Hints alternatingBars = currentProfile ? static_cast<Enum::Hints>(currentProfile->property<int>(Profile::AlternatingBars)) : Enum::HintsNever;
-    const Enum::Hints alternatingBackground =
-        currentProfile ? static_cast<Enum::Hints>(currentProfile->property<int>(Profile::AlternatingBackground)) : Enum::HintsNever;
+    const bool wordMode = m_profileSettings.wordMode;
+    const bool wordModeAttr = m_profileSettings.wordModeAttr;
+    const bool wordModeAscii = m_profileSettings.wordModeAscii;
+    const bool wordModeBrahmic = m_profileSettings.wordModeBrahmic;
+    const bool wordModeCoding = m_profileSettings.wordModeCoding;
+    const bool invertedRendition = m_profileSettings.invertedRendition;
+    const Enum::Hints semanticHints = m_profileSettings.semanticHints;
+    const Enum::Hints lineNumbers = m_profileSettings.lineNumbers;
+    const Enum::Hints errorBars = m_profileSettings.errorBars;
+    const Enum::Hints errorBackground = m_profileSettings.errorBackground;
+    const Enum::Hints alternatingBars = m_profileSettings.alternatingBars;
+    const Enum::Hints alternatingBackground = m_profileSettings.alternatingBackground;
     const bool showHints = m_parentDisplay->filterChain()->showUrlHint();
 #define hintActive(h) const bool h##Active = ((h == Enum::HintsURL && showHints) || h == Enum::HintsAlways)
     hintActive(semanticHints);
@@ -336,13 +360,15 @@ void TerminalPainter::drawContents(Character *image,
         //(instead of textArea.topLeft() * painter-scale)
         QString line;
 #define MAX_LINE_WIDTH 1024
-#define vis2log(x) ((bidiEnabled && (x) <= lastNonSpace) ? line2log[vis2line[x]] : (x))
+#define vis2log(x) ((lineBidi && (x) <= lastNonSpace) ? line2log[vis2line[x]] : (x))
         int log2line[MAX_LINE_WIDTH];
         int line2log[MAX_LINE_WIDTH];
         uint16_t shapemap[MAX_LINE_WIDTH];
         int32_t vis2line[MAX_LINE_WIDTH];
         bool shaped;
-        int lastNonSpace = m_parentDisplay->bidiMap(image + pos, line, log2line, line2log, shapemap, vis2line, shaped, bidiEnabled, bidiEnabled);
+        // Lines without right-to-left or Arabic characters are displayed as is
+        const bool lineBidi = bidiEnabled && m_parentDisplay->lineNeedsBidi(image + pos);
+        int lastNonSpace = m_parentDisplay->bidiMap(image + pos, line, log2line, line2log, shapemap, vis2line, shaped, lineBidi, lineBidi);
         const QRect textArea(textScale.inverted().map(QPoint(textX, textY)), QSize(textWidth, textHeight));
         if (!printerFriendly) {
             QColor background = m_parentDisplay->terminalColor()->backgroundColor();
@@ -361,7 +387,7 @@ void TerminalPainter::drawContents(Character *image,
                           invertedRendition,
                           vis2line,
                           line2log,
-                          bidiEnabled,
+                          lineBidi,
                           lastNonSpace,
                           background,
                           y,
@@ -385,7 +411,7 @@ void TerminalPainter::drawContents(Character *image,
             const Character char_value = image[pos + log_x];
             const bool doubleWidth = image[qMin(pos + log_x + 1, imageSize - 1)].isRightHalfOfDoubleWide(); // East_Asian_Width wide character
 
-            if (!printerFriendly && lastCharType == 0 && char_value.isSpace() && char_value.rendition.f.cursor == 0) {
+            if (!printerFriendly && lastCharType == 0 && char_value.isSpace() && (!withCursor || char_value.rendition.f.cursor == 0)) {
                 continue;
             }
 
@@ -403,8 +429,10 @@ void TerminalPainter::drawContents(Character *image,
                     textX -= fontWidth * (doubleWidthLine ? 2 : 1);
                 }
                 if (!printerFriendly && char_value.rendition.f.cursor) {
-                    Character style = char_value;
                     m_parentDisplay->setVisualCursorPosition(x);
+                }
+                if (!printerFriendly && withCursor && char_value.rendition.f.cursor) {
+                    Character style = char_value;
 
                     if (style.rendition.f.selected) {
                         if (invertedRendition) {
@@ -450,6 +478,7 @@ void TerminalPainter::drawContents(Character *image,
                                                invertedRendition,
                                                lineProperty,
                                                printerFriendly,
+                                               withCursor,
                                                oldRendition,
                                                oldColor,
                                                normalWeight,
@@ -478,6 +507,7 @@ void TerminalPainter::drawContents(Character *image,
                                    invertedRendition,
                                    lineProperty,
                                    printerFriendly,
+                                   withCursor,
                                    oldRendition,
                                    oldColor,
                                    normalWeight,
@@ -493,6 +523,7 @@ void TerminalPainter::drawContents(Character *image,
                                invertedRendition,
                                lineProperty,
                                printerFriendly,
+                               withCursor,
                                oldRendition,
                                oldColor,
                                normalWeight,
@@ -509,7 +540,7 @@ void TerminalPainter::drawContents(Character *image,
                           invertedRendition,
                           vis2line,
                           line2log,
-                          bidiEnabled,
+                          lineBidi,
                           lastNonSpace,
                           ulColorTable);
         }
@@ -674,15 +705,8 @@ void TerminalPainter::drawCursor(QPainter &painter, const QRectF &cursorRect, co
 
     QColor color = m_parentDisplay->terminalColor()->cursorColor();
     QColor cursorColor = color.isValid() ? color : foregroundColor;
+    m_animatedCursorColor = cursorColor;
 
-    if (m_parentDisplay->cursorAnimating() && m_cursorAnim->state() == QAbstractAnimation::Running && !m_animatedCursorPolygon.isEmpty()) {
-        painter.setRenderHint(QPainter::Antialiasing, true);
-        painter.setBrush(cursorColor);
-        painter.setPen(Qt::NoPen);
-        painter.drawPolygon(m_animatedCursorPolygon, Qt::OddEvenFill);
-        painter.setRenderHint(QPainter::Antialiasing, false);
-        painter.setBrush(Qt::NoBrush);
-    }
     if (m_parentDisplay->cursorBlinking()) {
         return;
     }
@@ -712,6 +736,18 @@ void TerminalPainter::drawCursor(QPainter &painter, const QRectF &cursorRect, co
     }
 }
 
+void TerminalPainter::drawCursorAnimation(QPainter &painter)
+{
+    if (m_parentDisplay->cursorAnimating() && m_cursorAnim->state() == QAbstractAnimation::Running && !m_animatedCursorPolygon.isEmpty()) {
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        painter.setBrush(m_animatedCursorColor);
+        painter.setPen(Qt::NoPen);
+        painter.drawPolygon(m_animatedCursorPolygon, Qt::OddEvenFill);
+        painter.setRenderHint(QPainter::Antialiasing, false);
+        painter.setBrush(Qt::NoBrush);
+    }
+}
+
 void TerminalPainter::drawCharacters(QPainter &painter,
                                      const QRect &rect,
                                      const QString &text,
@@ -823,7 +859,7 @@ void TerminalPainter::drawLineCharString(TerminalDisplay *display, QPainter &pai
     QRect cellRect = {x, y, display->terminalFont()->fontWidth(), display->terminalFont()->fontHeight()};
     QVector<uint> ucs4str = str.toUcs4();
     for (int i = 0; i < ucs4str.length(); i++) {
-        LineBlockCharacters::draw(painter, cellRect.translated(i * display->terminalFont()->fontWidth(), 0), ucs4str[i], useBoldPen);
+        m_lineCharacterAtlas.draw(painter, cellRect.translated(i * display->terminalFont()->fontWidth(), 0), ucs4str[i], useBoldPen);
     }
     painter.setRenderHint(QPainter::Antialiasing, false);
 }
@@ -858,7 +894,7 @@ void TerminalPainter::drawBelowText(QPainter &painter,
                                     const bool invertedRendition,
                                     int *vis2line,
                                     int *line2log,
-                                    bool bidiEnabled,
+                                    bool lineBidi,
                                     int lastNonSpace,
                                     QColor background,
                                     int Y,
@@ -935,7 +971,7 @@ void TerminalPainter::drawAboveText(QPainter &painter,
                                     const bool invertedRendition,
                                     int *vis2line,
                                     int *line2log,
-                                    bool bidiEnabled,
+                                    bool lineBidi,
                                     int lastNonSpace,
                                     CharacterColor const *ulColorTable)
 {
@@ -1143,6 +1179,7 @@ void TerminalPainter::drawTextCharacters(QPainter &painter,
                                          const bool invertedRendition,
                                          const LineProperty lineProperty,
                                          bool printerFriendly,
+                                         bool withCursor,
                                          RenditionFlags &oldRendition,
                                          QColor oldColor,
                                          QFont::Weight normalWeight,
@@ -1179,7 +1216,7 @@ void TerminalPainter::drawTextCharacters(QPainter &painter,
             }
         }
         characterColor = foregroundColor;
-        if (style.rendition.f.cursor != 0 && !m_parentDisplay->cursorBlinking()) {
+        if (withCursor && style.rendition.f.cursor != 0 && !m_parentDisplay->cursorBlinking()) {
             updateCursorTextColor(backgroundColor, characterColor);
         }
         if (m_parentDisplay->filterChain()->showUrlHint()) {
@@ -1207,8 +1244,9 @@ void TerminalPainter::drawTextCharacters(QPainter &painter,
     // Note that QFont::weight/setWeight() returns/takes an int in Qt5,
     // and a QFont::Weight in Qt6
     QFont savedFont;
+    const bool useEmojiFont = (style.flags & EF_EMOJI_REPRESENTATION) && m_parentDisplay->terminalFont()->hasExtraFont(0);
     bool restoreFont = false;
-    if ((style.flags & EF_EMOJI_REPRESENTATION) && m_parentDisplay->terminalFont()->hasExtraFont(0)) {
+    if (useEmojiFont) {
         savedFont = painter.font();
         restoreFont = true;
         painter.setFont(m_parentDisplay->terminalFont()->getExtraFont(0));
@@ -1255,7 +1293,11 @@ void TerminalPainter::drawTextCharacters(QPainter &painter,
             // We shift half way down here to center
             y += m_parentDisplay->terminalFont()->lineSpacing() / 2;
         }
-        painter.drawText(rect.x(), y, text);
+        if (printerFriendly) {
+            painter.drawText(rect.x(), y, text);
+        } else {
+            drawCachedText(painter, rect.x(), y, text, useEmojiFont);
+        }
         if (0 && text.toUcs4().length() >= 1) {
             fprintf(stderr, " %lli  ", (qint64)text.toUcs4().length());
             for (int i = 0; i < text.toUcs4().length(); i++) {
@@ -1268,4 +1310,40 @@ void TerminalPainter::drawTextCharacters(QPainter &painter,
         painter.setFont(savedFont);
     }
 }
+
+void TerminalPainter::drawCachedText(QPainter &painter, int x, int y, const QString &text, bool extraFont)
+{
+    // Single characters, like the CJK text and the symbols which aren't
+    // drawn as words, use the glyphs which TerminalFont resolved for them
+    const qsizetype length = text.size();
+    if (length == 1 || (length == 2 && text[0].isHighSurrogate() && text[1].isLowSurrogate())) {
+        const char32_t ucs4 = length == 1 ? text[0].unicode() : QChar::surrogateToUcs4(text[0], text[1]);
+        const QGlyphRun *glyph = m_parentDisplay->terminalFont()->fallbackGlyph(ucs4, painter.font(), extraFont, painter.device());
+        if (glyph != nullptr) {
+            painter.drawGlyphRun(QPointF(x, y), *glyph);
+            return;
+        }
+    }
+
+    const GlyphRunKey key{text, painter.font(), painter.device()->logicalDpiY()};
+    GlyphRuns *glyphRuns = m_glyphRunCache.object(key);
+    if (glyphRuns == nullptr) {
+        QTextLayout layout(text, key.font, painter.device());
+        // drawContents() lays out the text from left to right
+        QTextOption option;
+        option.setTextDirection(Qt::LeftToRight);
+        layout.setTextOption(option);
+        layout.beginLayout();
+        const QTextLine line = layout.createLine();
+        layout.endLayout();
+
+        glyphRuns = new GlyphRuns{layout.glyphRuns(), line.isValid() ? line.ascent() : 0};
+        m_glyphRunCache.insert(key, glyphRuns);
+    }
+
+    const QPointF position(x, y - glyphRuns->ascent);
+    for (const QGlyphRun &glyphRun : std::as_const(glyphRuns->runs)) {
+        painter.drawGlyphRun(position, glyphRun);
+    }
+}
 }
@@ -10,6 +10,9 @@
 #define TERMINALPAINTER_HPP
 
 // Qt
+#include <QCache>
+#include <QFont>
+#include <QGlyphRun>
 #include <QPolygonF>
 #include <QRectF>
 #include <QVariantAnimation>
@@ -17,6 +20,7 @@
 
 // Konsole
 #include "../characters/Character.h"
+#include "../characters/LineBlockCharacters.h"
 #include "Enumeration.h"
 #include "ScreenWindow.h"
 #include "colorscheme/ColorSchemeWallpaper.h"
@@ -41,6 +45,9 @@ public:
     explicit TerminalPainter(TerminalDisplay *parentDisplay);
     ~TerminalPainter() override = default;
 
+    // reads the settings of the profile which affect drawing
+    void applyProfile(const Profile::Ptr &profile);
+
 public Q_SLOTS:
     // -- Drawing helpers --
 
@@ -48,14 +55,19 @@ public Q_SLOTS:
     // fragments according to their colors and styles and calls
     // drawTextFragment() or drawPrinterFriendlyTextFragment()
     // to draw the fragments
+    // the cursor is left out if 'withCursor' is false
     void drawContents(Character *image,
                       QPainter &paint,
                       const QRect &rect,
                       bool PrinterFriendly,
                       int imageSize,
                       bool bidiEnabled,
-                      QVector<LineProperty> lineProperties,
-                      CharacterColor const *ulColorTable = nullptr);
+                      const QVector<LineProperty> &lineProperties,
+                      CharacterColor const *ulColorTable = nullptr,
+                      bool withCursor = true);
+
+    // draws the cursor moving to its new position, if it is animated
+    void drawCursorAnimation(QPainter &painter);
 
     // draw a transparent rectangle over the line of the current match
     void drawCurrentResultRect(QPainter &painter, const QRect &searchResultRect);
@@ -92,6 +104,24 @@ private:
     void drawCursor(QPainter &painter, const QRectF &cursorRect, const QColor &foregroundColor, const QColor &backgroundColor, QColor &characterColor);
 
     TerminalDisplay *m_parentDisplay = nullptr;
+
+    // settings of the profile, see applyProfile()
+    struct ProfileSettings {
+        bool wordMode = false;
+        bool wordModeAttr = true;
+        bool wordModeAscii = true;
+        bool wordModeBrahmic = true;
+        bool wordModeCoding = true;
+        bool invertedRendition = false;
+        Enum::Hints semanticHints = Enum::HintsNever;
+        Enum::Hints lineNumbers = Enum::HintsNever;
+        Enum::Hints errorBars = Enum::HintsNever;
+        Enum::Hints errorBackground = Enum::HintsNever;
+        Enum::Hints alternatingBars = Enum::HintsNever;
+        Enum::Hints alternatingBackground = Enum::HintsNever;
+    };
+    ProfileSettings m_profileSettings;
+
     void drawBelowText(QPainter &painter,
                        const QRect &rect,
                        Character *style,
@@ -102,7 +132,7 @@ private:
                        const bool invertedRendition,
                        int *vis2line,
                        int *line2log,
-                       bool bidiEnabled,
+                       bool lineBidi,
                        int lastNonSpace,
                        QColor background,
                        int Y,
@@ -117,7 +147,7 @@ private:
                        const bool invertedRendition,
                        int *vis2line,
                        int *line2log,
-                       bool bidiEnabled,
+                       bool lineBidi,
                        int lastNonSpace,
                        CharacterColor const *ulColorTable);
     void drawImagesBelowText(QPainter &painter, const QRect &rect, int fontWidth, int fontHeight, int &placementIdx, QRegion &sixelRegion);
@@ -131,15 +161,50 @@ private:
                             const bool invertedRendition,
                             const LineProperty lineProperty,
                             bool printerFriendly,
+                            bool withCursor,
                             RenditionFlags &oldRendition,
                             QColor oldColor,
                             QFont::Weight normalWeight,
                             QFont::Weight boldWeight);
+    // draws text with the painter's font with its baseline at (x, y), like
+    // QPainter::drawText() does, reusing the glyph runs of text drawn before
+    // 'extraFont' is true if the painter's font is an extra font of TerminalFont
+    void drawCachedText(QPainter &painter, int x, int y, const QString &text, bool extraFont);
+
     void updateCursorAnimation(const QVariant &value);
     void onCursorPositionChanged(const QRectF &oldRect, const QRectF &newRect);
     QVariantAnimation *m_cursorAnim;
     QRectF m_lastTargetRect;
     QPolygonF m_animatedCursorPolygon;
+    QColor m_animatedCursorColor;
+
+    // The glyph runs of the text fragments drawn by drawCachedText(), so that
+    // the text of lines which are repainted without changes isn't laid out
+    // again
+    struct GlyphRunKey {
+        QString text;
+        QFont font;
+        int dpi;
+
+        bool operator==(const GlyphRunKey &other) const
+        {
+            return dpi == other.dpi && text == other.text && font == other.font;
+        }
+
+        friend size_t qHash(const GlyphRunKey &key, size_t seed = 0) noexcept
+        {
+            return qHashMulti(seed, key.text, key.font, key.dpi);
+        }
+    };
+    struct GlyphRuns {
+        QList<QGlyphRun> runs;
+        // distance from the top of the runs to the baseline
+        qreal ascent;
+    };
+    QCache<GlyphRunKey, GlyphRuns> m_glyphRunCache;
+
+    // line graphics drawn by drawLineCharString()
+    LineBlockCharacters::GlyphAtlas m_lineCharacterAtlas;
 };
 
 }
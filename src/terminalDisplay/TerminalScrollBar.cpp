@@ -24,6 +24,9 @@
 #include <QRect>
 #include <QToolTip>
 
+// STD
+#include <algorithm>
+
 namespace Konsole
 {
 TerminalScrollBar::TerminalScrollBar(QWidget *parent)
@@ -164,7 +167,7 @@ void TerminalScrollBar::applyScrollBarPosition(bool propagate)
 // display is much cheaper than re-rendering all the text for the
 // part of the image which has moved up or down.
 // Instead only new lines have to be drawn
-void TerminalScrollBar::scrollImage(int lines, const QRect &screenWindowRegion, Character *image, int imageSize)
+void TerminalScrollBar::scrollImage(int lines, const QRect &screenWindowRegion, Character *image, int imageSize, QVector<quint64> &lineGenerations)
 {
     // return if there is nothing to do
     if ((lines == 0) || (image == nullptr)) {
@@ -184,45 +187,17 @@ void TerminalScrollBar::scrollImage(int lines, const QRect &screenWindowRegion,
         return;
     }
 
-    // Note:  With Qt 4.4 the left edge of the scrolled area must be at 0
-    // to get the correct (newly exposed) part of the widget repainted.
-    //
-    // The right edge must be before the left edge of the scroll bar to
-    // avoid triggering a repaint of the entire widget, the distance is
-    // given by SCROLLBAR_CONTENT_GAP
-    //
-    // Set the QT_FLUSH_PAINT environment variable to '1' before starting the
-    // application to monitor repainting.
-    //
-    const int scrollBarWidth = this->isHidden() ? 0 : this->width();
-    const int SCROLLBAR_CONTENT_GAP = 1;
-    QRect scrollRect;
-    if (_scrollbarLocation == Enum::ScrollBarLeft) {
-        scrollRect.setLeft(scrollBarWidth + SCROLLBAR_CONTENT_GAP
-                           + (_highlightScrolledLines.isEnabled() ? _highlightScrolledLines.HIGHLIGHT_SCROLLED_LINES_WIDTH : 0));
-        scrollRect.setRight(display->width());
-    } else {
-        scrollRect.setLeft(_highlightScrolledLines.isEnabled() ? _highlightScrolledLines.HIGHLIGHT_SCROLLED_LINES_WIDTH : 0);
-
-        scrollRect.setRight(display->width() - scrollBarWidth - SCROLLBAR_CONTENT_GAP);
-    }
     void *firstCharPos = &image[region.top() * display->columns()];
     void *lastCharPos = &image[(region.top() + abs(lines)) * display->columns()];
 
-    const int top = display->contentRect().top() + (region.top() * display->terminalFont()->fontHeight());
+    const int fontHeight = display->terminalFont()->fontHeight();
+    const int top = display->contentRect().top() + (region.top() * fontHeight);
     const int linesToMove = region.height() - abs(lines);
     const int bytesToMove = linesToMove * display->columns() * sizeof(Character);
 
     Q_ASSERT(linesToMove > 0);
     Q_ASSERT(bytesToMove > 0);
 
-    scrollRect.setTop(lines > 0 ? top : top + abs(lines) * display->terminalFont()->fontHeight());
-    scrollRect.setHeight(linesToMove * display->terminalFont()->fontHeight());
-
-    if (!scrollRect.isValid() || scrollRect.isEmpty()) {
-        return;
-    }
-
     // scroll internal image
     if (lines > 0) {
         // check that the memory areas that we are going to move are valid
@@ -231,16 +206,26 @@ void TerminalScrollBar::scrollImage(int lines, const QRect &screenWindowRegion,
 
         // scroll internal image down
         memmove(firstCharPos, lastCharPos, bytesToMove);
+        if (lineGenerations.size() >= region.top() + lines + linesToMove) {
+            std::move(lineGenerations.begin() + region.top() + lines,
+                      lineGenerations.begin() + region.top() + lines + linesToMove,
+                      lineGenerations.begin() + region.top());
+        }
     } else {
         // check that the memory areas that we are going to move are valid
         Q_ASSERT((char *)firstCharPos + bytesToMove < (char *)(image + (display->lines() * display->columns())));
 
         // scroll internal image up
         memmove(lastCharPos, firstCharPos, bytesToMove);
+        if (lineGenerations.size() >= region.top() - lines + linesToMove) {
+            std::move_backward(lineGenerations.begin() + region.top(),
+                               lineGenerations.begin() + region.top() + linesToMove,
+                               lineGenerations.begin() + region.top() - lines + linesToMove);
+        }
     }
 
-    // scroll the display vertically to match internal _image
-    display->scroll(0, display->terminalFont()->fontHeight() * (-lines), scrollRect);
+    // scroll the lines drawn by the display to match internal _image
+    display->scrollBackBuffer(QRect(0, top, display->width(), region.height() * fontHeight), -lines * fontHeight);
 }
 
 void TerminalScrollBar::changeEvent(QEvent *e)
@@ -79,7 +79,9 @@ public:
     // 'region' is the part of the image to scroll - currently only
     // the top, bottom and height of 'region' are taken into account,
     // the left and right are ignored.
-    void scrollImage(int lines, const QRect &screenWindowRegion, Character *image, int imageSize);
+    // 'lineGenerations' holds the generation of each line of 'image', which is
+    // scrolled along with it.
+    void scrollImage(int lines, const QRect &screenWindowRegion, Character *image, int imageSize, QVector<quint64> &lineGenerations);
 
     Enum::ScrollBarPositionEnum scrollBarPosition() const
     {